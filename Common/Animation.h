@@ -0,0 +1,359 @@
+//
+//  Animation.h
+//  Data-driven sprite animation. An AnimationLibrary reads clips from
+//  .anim description files (assets/animations/); an Animator keeps the
+//  playback state of many actors in parallel arrays and advances all of
+//  them with one pass per tick, writing a sheet id and UV rect per actor
+//  that can go straight into a SpriteQuad.
+//
+//  .anim format, one directive per line ('#' starts a comment):
+//    sheet <name> <image> <columns> <rows>    grid of equal cells, numbered
+//                                             row-major from the top left
+//    clip <name> <loop|once|pingpong>         starts a clip
+//    frames <sheet> <first> <count> <s>       `count` consecutive cells
+//    frame <sheet> <cell> <s>                 one cell
+//  Durations are in seconds and may differ between frames of a clip.
+//
+//  Each clip is resampled at load into a table of equal time slots (the
+//  largest slot that divides every frame boundary), so the update only
+//  needs a multiply and a lookup no matter how frame durations vary.
+//  UV rects use v = 0 at the top of the image, as stbi_load returns it;
+//  programs that load flipped use 1 - v.
+//
+
+#ifndef Animation_h
+#define Animation_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum AnimLoop : uint8_t { ANIM_LOOP, ANIM_ONCE, ANIM_PINGPONG };
+
+struct UVRect { float u0, v0, u1, v1; };
+
+struct AnimSheet {
+    std::string name, path;
+    int columns = 1, rows = 1;
+};
+
+struct AnimClip {
+    std::string name;
+    AnimLoop loop = ANIM_LOOP;
+    uint32_t firstFrame = 0, frameCount = 0;
+    uint32_t firstSlot = 0, slotCount = 0;
+    float slotSeconds = 0.0f;
+    float seconds = 0.0f;        // length of one pass through the frames
+};
+
+// --- CLIP LIBRARY ---
+class AnimationLibrary {
+public:
+    static const uint32_t MAX_CLIP_SLOTS = 4096;
+
+    // Adds the sheets and clips of a description; names must be unique
+    // across everything loaded into the library.
+    bool load(std::istream& in, const std::string& source = "anim") {
+        std::string line, word;
+        int lineNumber = 0;
+        int clip = -1;
+        std::vector<float> durations;   // of the clip being read
+        while (std::getline(in, line)) {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+            std::istringstream words(line);
+            if (!(words >> word)) continue;
+            bool ok = true;
+            if (word == "sheet") {
+                AnimSheet sheet;
+                ok = (bool)(words >> sheet.name >> sheet.path >> sheet.columns >> sheet.rows)
+                     && sheet.columns > 0 && sheet.rows > 0 && sheetId(sheet.name) < 0;
+                if (ok) sheets.push_back(sheet);
+            } else if (word == "clip") {
+                if (clip >= 0 && !closeClip(clip, durations)) return fail(source, lineNumber, "clip sem quadros");
+                AnimClip c;
+                std::string loop;
+                ok = (bool)(words >> c.name >> loop) && clipId(c.name) < 0;
+                if (loop == "loop") c.loop = ANIM_LOOP;
+                else if (loop == "once") c.loop = ANIM_ONCE;
+                else if (loop == "pingpong") c.loop = ANIM_PINGPONG;
+                else ok = false;
+                if (ok) {
+                    c.firstFrame = (uint32_t)frameSheet.size();
+                    clips.push_back(c);
+                    clip = (int)clips.size() - 1;
+                    durations.clear();
+                }
+            } else if (word == "frames" || word == "frame") {
+                std::string sheetName;
+                int first = 0, count = 1;
+                float seconds = 0.0f;
+                ok = (bool)(words >> sheetName >> first);
+                if (ok && word == "frames") ok = (bool)(words >> count);
+                ok = ok && (bool)(words >> seconds) && clip >= 0 && seconds > 0.0f && count > 0;
+                int sheet = ok ? sheetId(sheetName) : -1;
+                ok = ok && sheet >= 0 && first >= 0 && first + count <= sheets[sheet].columns * sheets[sheet].rows;
+                for (int k = 0; ok && k < count; ++k) {
+                    addFrame(sheet, first + k);
+                    durations.push_back(seconds);
+                }
+            } else {
+                ok = false;
+            }
+            if (!ok) return fail(source, lineNumber, line.c_str());
+        }
+        if (clip >= 0 && !closeClip(clip, durations)) return fail(source, lineNumber, "clip sem quadros");
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Erro ao abrir " << path << std::endl;
+            return false;
+        }
+        return load(file, path);
+    }
+
+    int clipId(const std::string& name) const {
+        for (size_t i = 0; i < clips.size(); ++i) if (clips[i].name == name) return (int)i;
+        return -1;
+    }
+    int sheetId(const std::string& name) const {
+        for (size_t i = 0; i < sheets.size(); ++i) if (sheets[i].name == name) return (int)i;
+        return -1;
+    }
+
+    const AnimClip& clip(int id) const { return clips[id]; }
+    const std::vector<AnimClip>& getClips() const { return clips; }
+    const std::vector<AnimSheet>& getSheets() const { return sheets; }
+
+    // Frames and slots are numbered across the whole library.
+    uint16_t frameSheetOf(uint32_t frame) const { return frameSheet[frame]; }
+    const UVRect& frameRect(uint32_t frame) const { return frameRects[frame]; }
+    uint32_t frameAt(uint32_t slot) const { return slotFrames[slot]; }
+    uint32_t totalFrames() const { return (uint32_t)frameRects.size(); }
+    // Every frame's rect in order, e.g. for a GPU UV table.
+    const UVRect* frameRectData() const { return frameRects.data(); }
+    // Per slot, the sheet and rect of the frame it shows.
+    const uint16_t* slotSheetData() const { return slotSheets.data(); }
+    const UVRect* slotRectData() const { return slotRects.data(); }
+
+private:
+    bool fail(const std::string& source, int lineNumber, const char* what) {
+        std::cerr << source << ":" << lineNumber << ": linha invalida: " << what << std::endl;
+        return false;
+    }
+
+    void addFrame(int sheet, int cell) {
+        const AnimSheet& s = sheets[sheet];
+        int col = cell % s.columns, row = cell / s.columns;
+        UVRect rect = { (float)col / s.columns, (float)row / s.rows,
+                        (float)(col + 1) / s.columns, (float)(row + 1) / s.rows };
+        frameSheet.push_back((uint16_t)sheet);
+        frameRects.push_back(rect);
+    }
+
+    // Builds the clip's slot table: the slot is the greatest common divisor
+    // of the frame durations (in microseconds), widened if the table would
+    // pass MAX_CLIP_SLOTS; each slot shows the frame covering its middle.
+    bool closeClip(int id, const std::vector<float>& durations) {
+        AnimClip& c = clips[id];
+        c.frameCount = (uint32_t)frameSheet.size() - c.firstFrame;
+        if (c.frameCount == 0) return false;
+        uint64_t quantum = 0, total = 0;
+        std::vector<uint64_t> ends;
+        for (float d : durations) {
+            uint64_t us = std::max<uint64_t>(1, (uint64_t)std::llround(d * 1e6));
+            uint64_t a = quantum, b = us;
+            while (b) { uint64_t t = a % b; a = b; b = t; }
+            quantum = a;
+            total += us;
+            ends.push_back(total);
+        }
+        quantum = std::max(quantum, (total + MAX_CLIP_SLOTS - 1) / MAX_CLIP_SLOTS);
+        c.slotCount   = (uint32_t)((total + quantum - 1) / quantum);
+        c.slotSeconds = quantum * 1e-6f;
+        c.seconds     = total * 1e-6f;
+        c.firstSlot   = (uint32_t)slotFrames.size();
+        uint32_t frame = 0;
+        for (uint32_t s = 0; s < c.slotCount; ++s) {
+            uint64_t middle = s * quantum + quantum / 2;
+            while (frame + 1 < c.frameCount && ends[frame] <= middle) frame++;
+            slotFrames.push_back(c.firstFrame + frame);
+            slotSheets.push_back(frameSheet[c.firstFrame + frame]);
+            slotRects.push_back(frameRects[c.firstFrame + frame]);
+        }
+        return true;
+    }
+
+    std::vector<AnimSheet> sheets;
+    std::vector<AnimClip> clips;
+    std::vector<uint16_t> frameSheet;   // per frame
+    std::vector<UVRect> frameRects;     // per frame
+    std::vector<uint32_t> slotFrames;   // per slot, the frame it shows
+    std::vector<uint16_t> slotSheets;   // per slot, copied from its frame
+    std::vector<UVRect> slotRects;
+};
+
+// --- PER-ACTOR PLAYBACK ---
+// Actors are indices into parallel arrays. play() copies what the update
+// needs from the clip into the actor's slots, so update() reads only
+// contiguous arrays: its first pass (time and slot) runs four actors per
+// SIMD instruction, the second looks up each actor's slot and writes sheet
+// and UV rect.
+class Animator {
+public:
+    explicit Animator(const AnimationLibrary* library = nullptr) : library(library) {}
+
+    void setLibrary(const AnimationLibrary* library) { this->library = library; }
+
+    void reserve(size_t count) {
+        time.reserve(count); speed.reserve(count); seconds.reserve(count); period.reserve(count); invPeriod.reserve(count);
+        once.reserve(count); slotsPerSecond.reserve(count); lastSlot.reserve(count); firstSlot.reserve(count);
+        clipOf.reserve(count);
+        slot.reserve(count); sheetOut.reserve(count); rectOut.reserve(count);
+    }
+
+    // Adds an actor playing `clip`, `startTime` seconds in; returns its index.
+    int add(int clip, float playbackSpeed = 1.0f, float startTime = 0.0f) {
+        time.push_back(0.0f); speed.push_back(std::max(playbackSpeed, 0.0f)); seconds.push_back(0.0f);
+        period.push_back(0.0f); invPeriod.push_back(0.0f); once.push_back(0.0f); slotsPerSecond.push_back(0.0f);
+        lastSlot.push_back(0); firstSlot.push_back(0); clipOf.push_back(-1);
+        slot.push_back(0); sheetOut.push_back(0); rectOut.push_back(UVRect{ 0.0f, 0.0f, 1.0f, 1.0f });
+        int actor = (int)time.size() - 1;
+        play(actor, clip, true);
+        time[actor] = startTime;
+        resolve(actor);
+        return actor;
+    }
+
+    // Switches the actor to `clip` from its start; playing the clip it
+    // already plays only restarts it when `restart` is set.
+    void play(int actor, int clip, bool restart = false) {
+        if (clipOf[actor] == clip && !restart) return;
+        const AnimClip& c = library->clip(clip);
+        clipOf[actor]         = clip;
+        time[actor]           = 0.0f;
+        seconds[actor]        = c.seconds;
+        slotsPerSecond[actor] = 1.0f / c.slotSeconds;
+        lastSlot[actor]       = (int32_t)c.slotCount - 1;
+        firstSlot[actor]      = (int32_t)c.firstSlot;
+        period[actor]         = c.loop == ANIM_PINGPONG ? 2.0f * c.seconds : c.seconds;
+        invPeriod[actor]      = 1.0f / period[actor];
+        once[actor]           = c.loop == ANIM_ONCE ? 1.0f : 0.0f;
+        resolve(actor);
+    }
+
+    // Playback rate, 1 = as authored; clips don't play backwards.
+    void setSpeed(int actor, float playbackSpeed) { speed[actor] = std::max(playbackSpeed, 0.0f); }
+
+    // Advances every actor by `dt` seconds.
+    void update(float dt) {
+        size_t n = time.size();
+        float* t = time.data();
+        const float* sp = speed.data();
+        const float* len = seconds.data();
+        const float* rate = slotsPerSecond.data();
+        const int32_t* last = lastSlot.data();
+        const int32_t* first = firstSlot.data();
+        const float* per = period.data();
+        const float* invPer = invPeriod.data();
+        const float* stop = once.data();
+        int32_t* out = slot.data();
+        // fixed-size blocks through local copies: GCC vectorizes these
+        // even at -O2, where a plain loop over the arrays stays scalar
+        size_t blocked = n / LANES * LANES;
+        for (size_t b = 0; b < blocked; b += LANES) {
+            float tb[LANES];
+            int32_t ob[LANES];
+            for (int k = 0; k < LANES; ++k) tb[k] = t[b + k];
+            for (int k = 0; k < LANES; ++k) {
+                size_t i = b + k;
+                ob[k] = advance(tb[k], dt * sp[i], len[i], per[i], invPer[i], stop[i], rate[i], last[i], first[i]);
+            }
+            for (int k = 0; k < LANES; ++k) {
+                t[b + k]   = tb[k];
+                out[b + k] = ob[k];
+            }
+        }
+        for (size_t i = blocked; i < n; ++i) out[i] = advance(t[i], dt * sp[i], len[i], per[i], invPer[i], stop[i], rate[i], last[i], first[i]);
+        const uint16_t* slotSheets = library->slotSheetData();
+        const UVRect* slotRects = library->slotRectData();
+        uint16_t* sheetDst = sheetOut.data();
+        UVRect* rectDst = rectOut.data();
+        for (size_t i = 0; i < n; ++i) {
+            sheetDst[i] = slotSheets[out[i]];
+            rectDst[i]  = slotRects[out[i]];
+        }
+    }
+
+    // Whole clear; actors are only ever added in bulk by the programs.
+    void clear() {
+        time.clear(); speed.clear(); seconds.clear(); period.clear(); invPeriod.clear(); once.clear(); slotsPerSecond.clear();
+        lastSlot.clear(); firstSlot.clear(); clipOf.clear(); slot.clear(); sheetOut.clear(); rectOut.clear();
+    }
+
+    size_t size() const { return time.size(); }
+    int clip(int actor) const { return clipOf[actor]; }
+    float elapsed(int actor) const { return time[actor]; }
+    // True once a `once` clip has reached its last frame's end.
+    bool finished(int actor) const { return once[actor] > 0.0f && time[actor] >= seconds[actor]; }
+    int frame(int actor) const { return (int)frameId(actor) - (int)library->clip(clipOf[actor]).firstFrame; }
+    // Frame number across the whole library, the index into its frame rects.
+    uint32_t frameId(int actor) const { return library->frameAt((uint32_t)slot[actor]); }
+
+    // Results of the last update(), one per actor.
+    uint16_t sheet(int actor) const { return sheetOut[actor]; }
+    const UVRect& rect(int actor) const { return rectOut[actor]; }
+    const uint16_t* sheets() const { return sheetOut.data(); }
+    const UVRect* rects() const { return rectOut.data(); }
+
+private:
+    static const int LANES = 4;   // floats per SSE register
+
+    // Moves `t` by `by` seconds within a clip of `length` seconds and
+    // returns the slot it lands in. `period` is twice the length for
+    // pingpong clips and `once` is 1 for clips that stop at the end; the
+    // modes are blended arithmetically rather than branched on, so
+    // update() vectorizes without -ffast-math.
+    static int32_t advance(float& t, float by, float length, float period, float invPeriod, float once,
+                           float rate, int32_t last, int32_t first) {
+        float next    = t + by;   // speeds and dt are never negative
+        float wrapped = next - (float)(int32_t)(next * invPeriod) * period;
+        float clamped = std::min(std::max(next, 0.0f), length);
+        next = wrapped + once * (clamped - wrapped);
+        t    = next;
+        float local = next + (float)(next > length) * (period - 2.0f * next);   // pingpong's way back
+        return first + std::min((int32_t)(local * rate), last);
+    }
+
+    // Recomputes one actor's slot and outputs without advancing time.
+    void resolve(int actor) {
+        slot[actor] = advance(time[actor], 0.0f, seconds[actor], period[actor], invPeriod[actor], once[actor],
+                              slotsPerSecond[actor], lastSlot[actor], firstSlot[actor]);
+        uint32_t frame = library->frameAt((uint32_t)slot[actor]);
+        sheetOut[actor] = library->frameSheetOf(frame);
+        rectOut[actor]  = library->frameRect(frame);
+    }
+
+    const AnimationLibrary* library;
+    // playback state
+    std::vector<float> time, speed;
+    // copied from the clip by play()
+    std::vector<float> seconds, period, invPeriod, once, slotsPerSecond;
+    std::vector<int32_t> lastSlot, firstSlot;
+    std::vector<int> clipOf;
+    // outputs
+    std::vector<int32_t> slot;
+    std::vector<uint16_t> sheetOut;
+    std::vector<UVRect> rectOut;
+};
+
+#endif /* Animation_h */
@@ -0,0 +1,143 @@
+//
+//  ColorIndex.h
+//  Finds every item whose RGB colour lies within a radius of a query
+//  colour. Colours (0..1 per channel) are bucketed in a uniform 3D grid
+//  over the RGB cube; a query looks at each bucket's box once:
+//    - boxes entirely inside the sphere are taken whole, with no tests;
+//    - boxes entirely outside are skipped;
+//    - the rest test their items with squared distances over packed
+//      r/g/b arrays, a loop the compiler vectorizes.
+//  Small sets use a single bucket, which is the same brute-force scan.
+//  extractWithin() removes what it finds, for games that wipe matches.
+//
+
+#ifndef ColorIndex_h
+#define ColorIndex_h
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+class ColorIndex {
+public:
+    // Indexes `count` colours given as interleaved r, g, b floats; item ids
+    // are their positions. `resolution` buckets per axis, 0 picks one from
+    // the count (about 64 items per bucket, a single bucket for small sets).
+    void build(const float* rgb, uint32_t count, int resolution = 0) {
+        if (resolution <= 0) resolution = std::max(1, std::min(32, (int)std::cbrt(count / 64.0)));
+        res = resolution;
+        buckets.assign(res * res * res, Bucket());
+        std::vector<uint32_t> sizes(buckets.size(), 0);
+        for (uint32_t id = 0; id < count; ++id) sizes[bucketOf(rgb[id * 3], rgb[id * 3 + 1], rgb[id * 3 + 2])]++;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i].ids.reserve(sizes[i]);
+            buckets[i].r.reserve(sizes[i]);
+            buckets[i].g.reserve(sizes[i]);
+            buckets[i].b.reserve(sizes[i]);
+        }
+        for (uint32_t id = 0; id < count; ++id) {
+            const float* c = rgb + id * 3;
+            Bucket& bucket = buckets[bucketOf(c[0], c[1], c[2])];
+            bucket.ids.push_back(id);
+            bucket.r.push_back(c[0]);
+            bucket.g.push_back(c[1]);
+            bucket.b.push_back(c[2]);
+        }
+        total = count;
+    }
+
+    // Appends the ids within `radius` of (r, g, b) to `out`; returns how many.
+    size_t query(float r, float g, float b, float radius, std::vector<uint32_t>& out) {
+        return visit(r, g, b, radius, out, false);
+    }
+
+    // Like query(), but also removes the items found from the index.
+    size_t extractWithin(float r, float g, float b, float radius, std::vector<uint32_t>& out) {
+        size_t found = visit(r, g, b, radius, out, true);
+        total -= found;
+        return found;
+    }
+
+    size_t size() const { return total; }
+    int resolution() const { return res; }
+
+private:
+    struct Bucket {
+        std::vector<uint32_t> ids;
+        std::vector<float> r, g, b;
+    };
+
+    int cellOf(float v) const { return std::min(res - 1, std::max(0, (int)(v * res))); }
+    int bucketOf(float r, float g, float b) const { return (cellOf(r) * res + cellOf(g)) * res + cellOf(b); }
+
+    // Nearest and farthest squared distance from `v` to [lo, hi] on one axis.
+    static void axisRange(float v, float lo, float hi, float& nearSq, float& farSq) {
+        float near = v < lo ? lo - v : (v > hi ? v - hi : 0.0f);
+        float far  = std::max(v - lo, hi - v);
+        nearSq += near * near;
+        farSq  += far * far;
+    }
+
+    size_t visit(float r, float g, float b, float radius, std::vector<uint32_t>& out, bool remove) {
+        float radiusSq = radius * radius;
+        float cell = 1.0f / res;
+        size_t found = 0;
+        // only the buckets overlapping the query's bounding box
+        int r0 = cellOf(r - radius), r1 = cellOf(r + radius);
+        int g0 = cellOf(g - radius), g1 = cellOf(g + radius);
+        int b0 = cellOf(b - radius), b1 = cellOf(b + radius);
+        for (int i = r0; i <= r1; ++i) for (int j = g0; j <= g1; ++j) for (int k = b0; k <= b1; ++k) {
+            Bucket& bucket = buckets[(i * res + j) * res + k];
+            size_t n = bucket.ids.size();
+            if (n == 0) continue;
+            float nearSq = 0.0f, farSq = 0.0f;
+            axisRange(r, i * cell, (i + 1) * cell, nearSq, farSq);
+            axisRange(g, j * cell, (j + 1) * cell, nearSq, farSq);
+            axisRange(b, k * cell, (k + 1) * cell, nearSq, farSq);
+            if (nearSq > radiusSq) continue;
+            if (farSq <= radiusSq) {
+                out.insert(out.end(), bucket.ids.begin(), bucket.ids.end());
+                found += n;
+                if (remove) bucket = Bucket();
+                continue;
+            }
+            hits.resize(n);
+            const float* br = bucket.r.data();
+            const float* bg = bucket.g.data();
+            const float* bb = bucket.b.data();
+            uint8_t* hit = hits.data();
+            for (size_t m = 0; m < n; ++m) {
+                float dr = br[m] - r, dg = bg[m] - g, db = bb[m] - b;
+                hit[m] = dr * dr + dg * dg + db * db <= radiusSq;
+            }
+            size_t kept = 0;
+            for (size_t m = 0; m < n; ++m) {
+                if (hit[m]) {
+                    out.push_back(bucket.ids[m]);
+                    found++;
+                } else if (remove) {
+                    bucket.ids[kept] = bucket.ids[m];
+                    bucket.r[kept]   = br[m];
+                    bucket.g[kept]   = bg[m];
+                    bucket.b[kept]   = bb[m];
+                    kept++;
+                }
+            }
+            if (remove) {
+                bucket.ids.resize(kept);
+                bucket.r.resize(kept);
+                bucket.g.resize(kept);
+                bucket.b.resize(kept);
+            }
+        }
+        return found;
+    }
+
+    int res = 1;
+    size_t total = 0;
+    std::vector<Bucket> buckets;
+    std::vector<uint8_t> hits;   // scratch for the per-item tests
+};
+
+#endif /* ColorIndex_h */
@@ -0,0 +1,120 @@
+//
+//  CookedTexture.h
+//  Container written by the assetCooker tool: a texture already in the
+//  layout the GPU wants (mip chain, optional premultiplied alpha, RGBA8 or
+//  BC1/BC3/BC7 blocks), so loading it is a file read and one upload per
+//  level instead of a PNG decode and glGenerateMipmap. No GL here; see
+//  TextureLoader.h for the upload.
+//
+//  .ctex file (little-endian): "CTEX", uint32 version, format, flags,
+//  width, height, level count; then per level uint32 width, height, byte
+//  size and the data. Level 0 is the full image, top row first.
+//
+//  Cooked files live under assets/cooked/ with the source's path and a
+//  .ctex extension, next to manifest.txt, which records per source the
+//  FNV-1a hash of the source file, of its cook settings and of the output.
+//
+
+#ifndef CookedTexture_h
+#define CookedTexture_h
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Hash.h"
+
+const uint32_t CTEX_VERSION = 1;
+
+enum CookedFormat : uint32_t { CTEX_RGBA8, CTEX_BC1, CTEX_BC3, CTEX_BC7 };
+const uint32_t CTEX_PREMULTIPLIED = 1;   // flags
+const uint32_t CTEX_CUTOUT = 2;
+
+inline const char* cookedFormatName(uint32_t format) {
+    static const char* names[] = { "rgba8", "bc1", "bc3", "bc7" };
+    return format <= CTEX_BC7 ? names[format] : "?";
+}
+
+// Bytes of one level; block formats round up to whole 4x4 blocks.
+inline size_t cookedLevelSize(uint32_t format, uint32_t width, uint32_t height) {
+    if (format == CTEX_RGBA8) return (size_t)width * height * 4;
+    size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == CTEX_BC1 ? 8 : 16);
+}
+
+// Alpha preparation shared by the cooker and the PNG fallback, so both give
+// the same texels: cutout clears pixels under half alpha, premultiply
+// scales colour by alpha.
+inline void prepareTexels(unsigned char* rgba, size_t pixels, bool cutout, bool premultiply) {
+    for (size_t i = 0; i < pixels; ++i) {
+        unsigned char* p = rgba + 4 * i;
+        if (cutout && p[3] < 128) {
+            p[0] = p[1] = p[2] = p[3] = 0;
+        } else if (premultiply) {
+            float alpha = p[3] / 255.0f;
+            p[0] = (unsigned char)(p[0] * alpha);
+            p[1] = (unsigned char)(p[1] * alpha);
+            p[2] = (unsigned char)(p[2] * alpha);
+        }
+    }
+}
+
+struct CookedLevel {
+    uint32_t width, height;
+    const unsigned char* data;
+    size_t size;
+};
+
+// A whole .ctex read in one go; levels point into `bytes`.
+struct CookedTexture {
+    uint32_t format = CTEX_RGBA8, flags = 0;
+    uint32_t width = 0, height = 0;
+    std::vector<CookedLevel> levels;
+    std::vector<unsigned char> bytes;
+
+    bool premultiplied() const { return (flags & CTEX_PREMULTIPLIED) != 0; }
+    bool cutout() const { return (flags & CTEX_CUTOUT) != 0; }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) return false;
+        bytes.resize((size_t)file.tellg());
+        file.seekg(0);
+        return file.read((char*)bytes.data(), bytes.size()) && parse();
+    }
+
+private:
+    bool parse() {
+        levels.clear();
+        uint32_t header[6];
+        if (bytes.size() < 28 || memcmp(bytes.data(), "CTEX", 4) != 0) return false;
+        memcpy(header, &bytes[4], sizeof(header));
+        if (header[0] != CTEX_VERSION || header[1] > CTEX_BC7) return false;
+        format = header[1]; flags = header[2]; width = header[3]; height = header[4];
+        size_t offset = 28;
+        for (uint32_t i = 0; i < header[5]; ++i) {
+            uint32_t level[3];
+            if (offset + sizeof(level) > bytes.size()) return false;
+            memcpy(level, &bytes[offset], sizeof(level));
+            offset += sizeof(level);
+            if (level[2] != cookedLevelSize(format, level[0], level[1]) || offset + level[2] > bytes.size()) return false;
+            levels.push_back(CookedLevel{ level[0], level[1], &bytes[offset], level[2] });
+            offset += level[2];
+        }
+        return !levels.empty();
+    }
+};
+
+// "../assets/sprites/a.png" -> "../assets/cooked/sprites/a.ctex"; empty if
+// the path is not under an assets directory.
+inline std::string cookedPathFor(const std::string& sourcePath) {
+    size_t at = sourcePath.find("assets/");
+    if (at == std::string::npos) return std::string();
+    std::string rest = sourcePath.substr(at + 7);
+    size_t dot = rest.rfind('.');
+    if (dot != std::string::npos && rest.find('/', dot) == std::string::npos) rest.erase(dot);
+    return sourcePath.substr(0, at + 7) + "cooked/" + rest + ".ctex";
+}
+
+#endif /* CookedTexture_h */
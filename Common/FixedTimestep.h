@@ -0,0 +1,55 @@
+//
+//  FixedTimestep.h
+//  Accumulator that turns variable frame times into a whole number of
+//  fixed simulation ticks. Rendering interpolates between the last two
+//  simulated states with alpha(), so motion stays smooth when the frame
+//  rate and the tick rate differ. A frame-time spike runs at most
+//  `maxTicksPerFrame` ticks and drops the rest instead of spiralling.
+//
+//      timestep.accumulate(frameTime);
+//      while (timestep.tick()) step(state, input);
+//      render(previous, state, timestep.alpha());
+//
+
+#ifndef FixedTimestep_h
+#define FixedTimestep_h
+
+class FixedTimestep {
+public:
+    explicit FixedTimestep(double tickRate = 60.0, int maxTicksPerFrame = 8)
+        : dt(1.0 / tickRate), maxTicks(maxTicksPerFrame) {}
+
+    void accumulate(double frameTime) {
+        if (frameTime < 0.0) frameTime = 0.0;
+        accumulator += frameTime;
+        ticksThisFrame = 0;
+        if (accumulator > dt * maxTicks) accumulator = dt * maxTicks;
+    }
+
+    // True while another tick is due this frame.
+    bool tick() {
+        if (accumulator < dt) return false;
+        accumulator -= dt;
+        ticksThisFrame++;
+        return true;
+    }
+
+    // Fraction of a tick left in the accumulator, in [0, 1).
+    float alpha() const { return (float)(accumulator / dt); }
+
+    // Seconds the simulation trails the wall clock. During the tick loop,
+    // frameStart - lag() is the moment the current tick ends at.
+    double lag() const { return accumulator; }
+
+    double step() const { return dt; }
+    int ticks() const { return ticksThisFrame; }
+    void reset() { accumulator = 0.0; ticksThisFrame = 0; }
+
+private:
+    double dt;
+    int maxTicks;
+    double accumulator = 0.0;
+    int ticksThisFrame = 0;
+};
+
+#endif /* FixedTimestep_h */
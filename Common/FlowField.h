@@ -0,0 +1,288 @@
+//
+//  FlowField.h
+//  Distance field from a set of goal cells over a grid of tile ids, plus
+//  the direction each cell should step in to get closer to a goal. Any
+//  number of agents steer with next(), a table lookup, so the cost per
+//  agent does not depend on the map size or the number of goals.
+//
+//  The field is built with Dial's algorithm, a Dijkstra that keeps its
+//  open list in buckets indexed by distance, which works because step
+//  costs are small integers. Leaving a tile costs its table cost times 10
+//  (times 14 diagonally). Every cell remembers the neighbour it got its
+//  distance from, so the directions form a forest rooted at the goals.
+//  Edits reuse that forest:
+//    - a cost decrease or a new goal relaxes outward from the cell;
+//    - a cost increase, a blocked tile or a removed goal resets only the
+//      subtree that hung from the cell and refills it from its border.
+//
+
+#ifndef FlowField_h
+#define FlowField_h
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+const int FLOW_BLOCKED     = -1;
+const uint32_t FLOW_UNREACHABLE = 0xFFFFFFFFu;
+const uint8_t FLOW_NONE    = 0xFF;   // goal or unreachable cell
+
+class FlowField {
+public:
+    static const int STEP_STRAIGHT = 10;
+    static const int STEP_DIAGONAL = 14;
+
+    FlowField() {
+        for (int i = 0; i < 256; ++i) costs[i] = 1;
+    }
+
+    // The tile array is read in place; report edits through setTile().
+    void setGrid(uint8_t* tiles, int width, int height, int neighbours = 8) {
+        this->tiles      = tiles;
+        this->width      = width;
+        this->height     = height;
+        this->neighbours = neighbours;
+        dist.assign(width * height, FLOW_UNREACHABLE);
+        dir.assign(width * height, FLOW_NONE);
+        goal.assign(width * height, 0);
+    }
+
+    // Cost of leaving a tile id, 1..255, or FLOW_BLOCKED. Call compute() after.
+    void setCost(uint8_t tile, int cost) {
+        costs[tile] = cost;
+        int maxCost = 1;
+        for (int i = 0; i < 256; ++i) if (costs[i] > maxCost) maxCost = costs[i];
+        ring = maxCost * STEP_DIAGONAL + 1;
+    }
+
+    // Rebuilds the whole field from the given goal cells.
+    void compute(const std::vector<int>& goals) {
+        std::fill(dist.begin(), dist.end(), FLOW_UNREACHABLE);
+        std::fill(dir.begin(), dir.end(), FLOW_NONE);
+        std::fill(goal.begin(), goal.end(), 0);
+        resetBuckets();
+        for (int cell : goals) {
+            if (!walkable(cell)) continue;
+            goal[cell] = 1;
+            dist[cell] = 0;
+            push(cell, 0);
+        }
+        propagate();
+    }
+
+    void addGoal(int cell) {
+        if (goal[cell] || !walkable(cell)) return;
+        goal[cell] = 1;
+        dist[cell] = 0;
+        dir[cell]  = FLOW_NONE;
+        resetBuckets();
+        push(cell, 0);
+        propagate();
+    }
+
+    void removeGoal(int cell) {
+        if (!goal[cell]) return;
+        goal[cell] = 0;
+        roots.assign(1, cell);
+        invalidateSubtrees();
+    }
+
+    // Changes a tile id and repairs the part of the field that depended on it.
+    void setTile(int cell, uint8_t tile) {
+        int before = costs[tiles[cell]];
+        tiles[cell] = tile;
+        int after = costs[tile];
+        if (before == after) return;
+        if (after == FLOW_BLOCKED) {
+            // the cell and any diagonal that cut past its corners go away
+            goal[cell] = 0;
+            roots.assign(1, cell);
+            for (int d = 0; d < 8; ++d) {
+                int x = cell % width + DX[d], y = cell / width + DY[d];
+                if (x < 0 || y < 0 || x >= width || y >= height) continue;
+                int n = y * width + x;
+                if (dir[n] != FLOW_NONE && dir[n] >= 4) roots.push_back(n);
+            }
+            invalidateSubtrees();
+        } else if (before == FLOW_BLOCKED || after < before) {
+            // the cell, and around a reopened tile its neighbours, may improve
+            resetBuckets();
+            relaxFromNeighbours(cell);
+            if (before == FLOW_BLOCKED) {
+                for (int d = 0; d < 8; ++d) {
+                    int x = cell % width + DX[d], y = cell / width + DY[d];
+                    if (x >= 0 && y >= 0 && x < width && y < height) relaxFromNeighbours(y * width + x);
+                }
+            }
+            propagate();
+        } else {
+            roots.assign(1, cell);
+            invalidateSubtrees();
+        }
+    }
+
+    // Neighbour cell to move to from `cell`, or -1 at a goal / when no goal is reachable.
+    int next(int cell) const {
+        uint8_t d = dir[cell];
+        if (d == FLOW_NONE) return -1;
+        return cell + DY[d] * width + DX[d];
+    }
+
+    uint32_t distance(int cell) const { return dist[cell]; }
+    bool isGoal(int cell) const { return goal[cell] != 0; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Cells settled by the last compute() or edit, for profiling.
+    unsigned lastSettled() const { return settled; }
+
+private:
+    static constexpr int DX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+    static constexpr int DY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+    bool walkable(int cell) const { return costs[tiles[cell]] != FLOW_BLOCKED; }
+
+    // Neighbour of `cell` in direction d, or -1 if the step is not allowed
+    // (off the grid, blocked, or a diagonal cutting a blocked corner).
+    int neighbour(int cell, int d) const {
+        int x = cell % width + DX[d], y = cell / width + DY[d];
+        if (x < 0 || y < 0 || x >= width || y >= height) return -1;
+        int n = y * width + x;
+        if (!walkable(n)) return -1;
+        if (d >= 4 && (!walkable(cell + DX[d]) || !walkable(cell + DY[d] * width))) return -1;
+        return n;
+    }
+
+    int stepCost(int cell, int d) const {
+        return costs[tiles[cell]] * (d >= 4 ? STEP_DIAGONAL : STEP_STRAIGHT);
+    }
+
+    // Lowest distance `cell` can get from its neighbours; `bestDir` receives the direction.
+    uint32_t bestFromNeighbours(int cell, uint8_t& bestDir) const {
+        uint32_t best = FLOW_UNREACHABLE;
+        if (!walkable(cell)) return best;
+        for (int d = 0; d < neighbours; ++d) {
+            int n = neighbour(cell, d);
+            if (n < 0 || dist[n] == FLOW_UNREACHABLE) continue;
+            uint32_t candidate = dist[n] + stepCost(cell, d);
+            if (candidate < best) { best = candidate; bestDir = (uint8_t)d; }
+        }
+        return best;
+    }
+
+    void relaxFromNeighbours(int cell) {
+        if (goal[cell]) return;
+        uint8_t bestDir = dir[cell];
+        uint32_t best = bestFromNeighbours(cell, bestDir);
+        if (best >= dist[cell]) return;
+        dist[cell] = best;
+        dir[cell]  = bestDir;
+        push(cell, best);
+    }
+
+    void resetBuckets() {
+        if ((int)buckets.size() != ring) buckets.assign(ring, std::vector<int>());
+        for (std::vector<int>& bucket : buckets) bucket.clear();
+        seeds.clear();
+        pending = 0;
+        settled = 0;
+    }
+
+    // Starting points may lie far apart, so they wait in a sorted list and
+    // enter the bucket ring once it reaches them.
+    void push(int cell, uint32_t d) {
+        seeds.push_back(Seed{ d, cell });
+    }
+
+    // Dial's algorithm from the seeds. Bucket entries whose cell has since
+    // been lowered are stale and skipped.
+    void propagate() {
+        std::sort(seeds.begin(), seeds.end(), [](const Seed& a, const Seed& b) { return a.dist < b.dist; });
+        size_t nextSeed = 0;
+        current = seeds.empty() ? 0 : seeds[0].dist;
+        while (pending > 0 || nextSeed < seeds.size()) {
+            if (pending == 0 && seeds[nextSeed].dist > current) current = seeds[nextSeed].dist;
+            while (nextSeed < seeds.size() && seeds[nextSeed].dist <= current) {
+                const Seed& seed = seeds[nextSeed++];
+                if (dist[seed.cell] != seed.dist) continue;
+                buckets[current % ring].push_back(seed.cell);
+                pending++;
+            }
+            std::vector<int>& bucket = buckets[current % ring];
+            while (!bucket.empty()) {
+                int cell = bucket.back();
+                bucket.pop_back();
+                pending--;
+                if (dist[cell] != current) continue;
+                settled++;
+                // relax every cell that could step into this one
+                for (int d = 0; d < neighbours; ++d) {
+                    int n = neighbour(cell, d);
+                    if (n < 0 || goal[n]) continue;
+                    int back = OPPOSITE[d];
+                    uint32_t candidate = current + stepCost(n, back);
+                    if (candidate < dist[n]) {
+                        dist[n] = candidate;
+                        dir[n]  = (uint8_t)back;
+                        buckets[candidate % ring].push_back(n);
+                        pending++;
+                    }
+                }
+            }
+            current++;
+        }
+    }
+
+    // Resets every cell whose direction chain passes through one of the
+    // roots, then refills that region from the cells around it.
+    void invalidateSubtrees() {
+        resetBuckets();
+        affected.clear();
+        for (int root : roots) {
+            if (goal[root] || dist[root] == FLOW_UNREACHABLE) continue;
+            dist[root] = FLOW_UNREACHABLE;
+            dir[root]  = FLOW_NONE;
+            affected.push_back(root);
+        }
+        for (size_t i = 0; i < affected.size(); ++i) {
+            int cell = affected[i];
+            for (int d = 0; d < 8; ++d) {
+                int x = cell % width + DX[d], y = cell / width + DY[d];
+                if (x < 0 || y < 0 || x >= width || y >= height) continue;
+                int n = y * width + x;
+                if (dir[n] == OPPOSITE[d] && dist[n] != FLOW_UNREACHABLE) {
+                    dist[n] = FLOW_UNREACHABLE;
+                    dir[n]  = FLOW_NONE;
+                    affected.push_back(n);
+                }
+            }
+        }
+        for (int cell : affected) {
+            uint8_t bestDir = FLOW_NONE;
+            uint32_t best = bestFromNeighbours(cell, bestDir);
+            if (best == FLOW_UNREACHABLE) continue;
+            dist[cell] = best;
+            dir[cell]  = bestDir;
+            push(cell, best);
+        }
+        propagate();
+    }
+
+    static constexpr int OPPOSITE[8] = { 2, 3, 0, 1, 6, 7, 4, 5 };
+
+    uint8_t* tiles = nullptr;
+    int width = 0, height = 0, neighbours = 8;
+    int costs[256];
+    int ring = STEP_DIAGONAL + 1;
+    std::vector<uint32_t> dist;
+    std::vector<uint8_t> dir, goal;
+    struct Seed { uint32_t dist; int cell; };
+    std::vector<std::vector<int>> buckets;
+    std::vector<Seed> seeds;
+    std::vector<int> affected, roots;
+    size_t pending = 0;
+    uint32_t current = 0;
+    unsigned settled = 0;
+};
+
+#endif /* FlowField_h */
@@ -0,0 +1,164 @@
+//
+//  GLStateCache.h
+//  Shadow copy of the GL binding state. Draw code binds through glState
+//  so that requests for state that is already current never reach the
+//  driver; both outcomes are counted per frame.
+//
+
+#ifndef GLStateCache_h
+#define GLStateCache_h
+
+#include <glad/glad.h>
+
+struct GLStateStats {
+    unsigned issued   = 0;   // state changes forwarded to GL
+    unsigned filtered = 0;   // redundant requests dropped by the cache
+};
+
+class GLStateCache {
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    GLStateCache() { invalidate(); }
+
+    // Forgets everything; call after code that touched GL state directly.
+    void invalidate() {
+        program = vertexArray = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int i = 0; i < BUFFER_TARGETS; ++i) buffers[i] = UNKNOWN;
+        for (int u = 0; u < MAX_TEXTURE_UNITS; ++u)
+            for (int t = 0; t < TEXTURE_TARGETS; ++t) textures[u][t] = UNKNOWN;
+        blendEnabled = -1;
+        blendSrc = blendDst = UNKNOWN;
+        viewportRect[0] = viewportRect[1] = viewportRect[2] = viewportRect[3] = -1;
+    }
+
+    void useProgram(GLuint id) {
+        if (!changed(program, id)) return;
+        glUseProgram(id);
+    }
+
+    void bindVertexArray(GLuint id) {
+        if (!changed(vertexArray, id)) return;
+        glBindVertexArray(id);
+        // the element array binding belongs to the VAO
+        buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+    }
+
+    void bindBuffer(GLenum target, GLuint id) {
+        int slot = bufferSlot(target);
+        if (slot < 0) { glBindBuffer(target, id); stats.issued++; return; }
+        if (!changed(buffers[slot], id)) return;
+        glBindBuffer(target, id);
+    }
+
+    // Indexed bindings are not cached, but they also rebind the generic target.
+    void bindBufferBase(GLenum target, GLuint index, GLuint id) {
+        glBindBufferBase(target, index, id);
+        stats.issued++;
+        int slot = bufferSlot(target);
+        if (slot >= 0) buffers[slot] = id;
+    }
+
+    void activeTexture(GLuint unit) {
+        if (!changed(activeUnit, unit)) return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void bindTexture(GLuint unit, GLenum target, GLuint id) {
+        int slot = textureSlot(target);
+        if (unit < MAX_TEXTURE_UNITS && slot >= 0 && textures[unit][slot] == id) {
+            stats.filtered++;
+            return;
+        }
+        activeTexture(unit);
+        glBindTexture(target, id);
+        stats.issued++;
+        if (unit < MAX_TEXTURE_UNITS && slot >= 0) textures[unit][slot] = id;
+    }
+
+    void setBlend(bool enabled, GLenum src = GL_SRC_ALPHA, GLenum dst = GL_ONE_MINUS_SRC_ALPHA) {
+        if (blendEnabled == (int)enabled) stats.filtered++;
+        else {
+            if (enabled) glEnable(GL_BLEND);
+            else         glDisable(GL_BLEND);
+            blendEnabled = enabled;
+            stats.issued++;
+        }
+        if (!enabled) return;
+        if (blendSrc == src && blendDst == dst) { stats.filtered++; return; }
+        glBlendFunc(src, dst);
+        blendSrc = src;
+        blendDst = dst;
+        stats.issued++;
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        if (viewportRect[0] == x && viewportRect[1] == y && viewportRect[2] == width && viewportRect[3] == height) {
+            stats.filtered++;
+            return;
+        }
+        glViewport(x, y, width, height);
+        viewportRect[0] = x; viewportRect[1] = y; viewportRect[2] = width; viewportRect[3] = height;
+        stats.issued++;
+    }
+
+    // Drops a buffer name about to be deleted, since GL rebinds its targets to 0.
+    void forgetBuffer(GLuint id) {
+        for (int i = 0; i < BUFFER_TARGETS; ++i) if (buffers[i] == id) buffers[i] = UNKNOWN;
+    }
+
+    // Returns the counters of the frame that just ended and starts a new one.
+    GLStateStats endFrame() {
+        GLStateStats frame = stats;
+        stats = GLStateStats();
+        return frame;
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int BUFFER_TARGETS = 6;
+    static const int TEXTURE_TARGETS = 4;
+
+    static int bufferSlot(GLenum target) {
+        switch (target) {
+            case GL_ARRAY_BUFFER:         return 0;
+            case GL_ELEMENT_ARRAY_BUFFER: return 1;
+            case GL_UNIFORM_BUFFER:       return 2;
+            case GL_COPY_READ_BUFFER:     return 3;
+            case GL_COPY_WRITE_BUFFER:    return 4;
+            case GL_PIXEL_UNPACK_BUFFER:  return 5;
+        }
+        return -1;
+    }
+
+    static int textureSlot(GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D:       return 0;
+            case GL_TEXTURE_2D_ARRAY: return 1;
+            case GL_TEXTURE_BUFFER:   return 2;
+            case GL_TEXTURE_3D:       return 3;
+        }
+        return -1;
+    }
+
+    bool changed(GLuint& current, GLuint wanted) {
+        if (current == wanted) { stats.filtered++; return false; }
+        current = wanted;
+        stats.issued++;
+        return true;
+    }
+
+    GLuint program, vertexArray, activeUnit;
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS];
+    int blendEnabled;
+    GLenum blendSrc, blendDst;
+    GLint viewportRect[4];
+    GLStateStats stats;
+};
+
+// Single context per executable, so a single cache.
+inline GLStateCache glState;
+
+#endif /* GLStateCache_h */
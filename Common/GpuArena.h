@@ -0,0 +1,114 @@
+//
+//  GpuArena.h
+//  Append-only GPU buffer for geometry that only grows, such as shapes
+//  the user keeps adding. Appends upload just the new bytes; when the
+//  buffer is full its capacity doubles and the old contents are copied
+//  GPU-side with glCopyBufferSubData, so adding an element is amortized
+//  O(1) and everything appended can be drawn with one call.
+//
+//  Growing replaces the buffer object. Code that points a VAO at id()
+//  should compare getGeneration() with the value it last saw and re-point.
+//  Uploads go through GL_COPY_WRITE_BUFFER so the array and element
+//  bindings (the latter is VAO state) are never disturbed.
+//
+//  Call release() before glfwTerminate; a global arena is destroyed after
+//  the context is gone, so the destructor frees nothing.
+//
+
+#ifndef GpuArena_h
+#define GpuArena_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include "GLStateCache.h"
+
+class GpuArena {
+public:
+    void init(GLsizeiptr initialCapacity = 64 * 1024, GLenum usage = GL_DYNAMIC_DRAW) {
+        release();
+        this->usage = usage;
+        capacity    = std::max<GLsizeiptr>(initialCapacity, 256);
+        used        = written = 0;
+        glGenBuffers(1, &buffer);
+        glState.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, usage);
+        generation++;
+    }
+
+    void release() {
+        if (!buffer) return;
+        glState.forgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    // Copies `bytes` to the end of the arena and returns their offset.
+    GLintptr append(const void* data, GLsizeiptr bytes) {
+        reserve(used + bytes);
+        GLintptr offset = used;
+        glState.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, data);
+        used += bytes;
+        written = std::max(written, used);
+        return offset;
+    }
+
+    // Mapped append for large batches: returns memory for `bytes` at the end
+    // of the arena to fill before endAppend(). Bytes past everything ever
+    // written cannot be in use by the GPU, so that case maps unsynchronized.
+    void* beginAppend(GLsizeiptr bytes) {
+        reserve(used + bytes);
+        glState.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        pendingBytes = bytes;
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        if (used >= written) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+        return glMapBufferRange(GL_COPY_WRITE_BUFFER, used, bytes, access);
+    }
+
+    void endAppend() {
+        glState.bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        if (glUnmapBuffer(GL_COPY_WRITE_BUFFER)) used += pendingBytes;
+        written = std::max(written, used);
+        pendingBytes = 0;
+    }
+
+    // Makes room for `bytes` in total, doubling the capacity as needed.
+    void reserve(GLsizeiptr bytes) {
+        if (bytes <= capacity) return;
+        GLsizeiptr grown = capacity;
+        while (grown < bytes) grown *= 2;
+        GLuint replacement;
+        glGenBuffers(1, &replacement);
+        glState.bindBuffer(GL_COPY_WRITE_BUFFER, replacement);
+        glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, usage);
+        if (used > 0) {
+            glState.bindBuffer(GL_COPY_READ_BUFFER, buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        }
+        glState.forgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+        buffer   = replacement;
+        capacity = grown;
+        written  = used;
+        generation++;
+        grows++;
+    }
+
+    // Drops the contents but keeps the storage.
+    void clear() { used = 0; }
+
+    GLuint id() const { return buffer; }
+    GLsizeiptr size() const { return used; }
+    GLsizeiptr getCapacity() const { return capacity; }
+    unsigned getGeneration() const { return generation; }
+    unsigned growCount() const { return grows; }
+
+private:
+    GLuint buffer = 0;
+    GLenum usage = GL_DYNAMIC_DRAW;
+    GLsizeiptr capacity = 0, used = 0, pendingBytes = 0;
+    GLsizeiptr written = 0;   // high-water mark of bytes ever stored since the buffer was created
+    unsigned generation = 0, grows = 0;
+};
+
+#endif /* GpuArena_h */
@@ -0,0 +1,27 @@
+//
+//  Hash.h
+//  FNV-1a, 64 bits: content hashes for the asset cooker's manifest and the
+//  shader binary cache keys. Not for hash tables or anything adversarial.
+//
+
+#ifndef Hash_h
+#define Hash_h
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a64(const std::string& text, uint64_t hash = 14695981039346656037ull) {
+    return fnv1a64(text.data(), text.size(), hash);
+}
+
+#endif /* Hash_h */
@@ -0,0 +1,304 @@
+//
+//  InputQueue.h
+//  Lossless input for fixed-tick games. Window callbacks push timestamped
+//  events into a lock-free single-producer/single-consumer ring; each
+//  simulation tick pops the events that happened before the moment it
+//  simulates and folds them into discrete actions. A key tapped between
+//  two frames is still seen, and a slow frame's events are spread over
+//  the ticks it runs instead of all landing on the first.
+//
+//      // callback (producer)
+//      inputQueue.push(InputEvent::key(glfwGetTime(), key, action, mods));
+//      // tick loop (consumer)
+//      InputEvent event;
+//      while (inputQueue.popUntil(now - timestep.lag(), event)) actions.apply(event);
+//
+//  InputRecorder / InputPlayer save the events each tick consumed and
+//  feed them back at the same ticks, which replays a session exactly;
+//  Replay.h builds the command-line replay runner on top of them.
+//  Nothing here depends on GLFW; codes and actions use GLFW's values.
+//
+
+#ifndef InputQueue_h
+#define InputQueue_h
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+enum InputEventType : uint8_t { INPUT_KEY, INPUT_MOUSE_BUTTON, INPUT_CURSOR, INPUT_SCROLL };
+
+// Same values as GLFW_RELEASE, GLFW_PRESS and GLFW_REPEAT.
+const int INPUT_RELEASE = 0;
+const int INPUT_PRESS   = 1;
+const int INPUT_REPEAT  = 2;
+
+struct InputEvent {
+    double time = 0.0;       // seconds, on the clock the tick loop uses
+    uint8_t type = INPUT_KEY;
+    int8_t action = 0;       // INPUT_RELEASE / PRESS / REPEAT
+    int16_t mods = 0;
+    int32_t code = 0;        // key or mouse button
+    float x = 0.0f, y = 0.0f;   // cursor position or scroll offset
+
+    static InputEvent key(double time, int key, int action, int mods) {
+        InputEvent e;
+        e.time = time; e.type = INPUT_KEY; e.code = key; e.action = (int8_t)action; e.mods = (int16_t)mods;
+        return e;
+    }
+    static InputEvent mouseButton(double time, int button, int action, int mods, double x, double y) {
+        InputEvent e = key(time, button, action, mods);
+        e.type = INPUT_MOUSE_BUTTON; e.x = (float)x; e.y = (float)y;
+        return e;
+    }
+    static InputEvent cursor(double time, double x, double y) {
+        InputEvent e;
+        e.time = time; e.type = INPUT_CURSOR; e.x = (float)x; e.y = (float)y;
+        return e;
+    }
+};
+
+// --- EVENT RING ---
+// One thread pushes, one pops. Capacity is a power of two; when the ring
+// is full push() fails and the event is counted in dropped().
+class InputQueue {
+public:
+    static const uint32_t CAPACITY = 1024;
+
+    bool push(const InputEvent& event) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) { droppedEvents++; return false; }
+        ring[t & (CAPACITY - 1)] = event;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(InputEvent& event) { return popUntil(1e300, event); }
+
+    // Pops the oldest event if it happened at or before `time`.
+    bool popUntil(double time, InputEvent& event) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        const InputEvent& front = ring[h & (CAPACITY - 1)];
+        if (front.time > time) return false;
+        event = front;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void clear() { head.store(tail.load(std::memory_order_acquire), std::memory_order_release); }
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    unsigned dropped() const { return droppedEvents; }
+
+private:
+    InputEvent ring[CAPACITY];
+    alignas(64) std::atomic<uint32_t> head{ 0 };   // next to pop, owned by the consumer
+    alignas(64) std::atomic<uint32_t> tail{ 0 };   // next to push, owned by the producer
+    unsigned droppedEvents = 0;
+};
+
+// --- DISCRETE ACTIONS ---
+// Keys or mouse buttons bound to up to 32 actions. held() follows press
+// and release; presses() counts presses and key repeats since the last
+// endTick(), so a press released within the same tick is not lost.
+class InputActions {
+public:
+    static const int MAX_ACTIONS = 32;
+
+    void bind(int code, int action, uint8_t type = INPUT_KEY) {
+        if (bindingCount < MAX_BINDINGS) bindings[bindingCount++] = Binding{ code, action, type };
+    }
+
+    void apply(const InputEvent& event) {
+        for (int i = 0; i < bindingCount; ++i) {
+            const Binding& b = bindings[i];
+            if (b.type != event.type || b.code != event.code) continue;
+            uint32_t bit = 1u << b.action;
+            if (event.action == INPUT_RELEASE) heldMask &= ~bit;
+            else {
+                if (event.action == INPUT_PRESS) heldMask |= bit;
+                if (pressCounts[b.action] < 255) pressCounts[b.action]++;
+            }
+        }
+    }
+
+    bool held(int action) const { return (heldMask >> action) & 1u; }
+    int presses(int action) const { return pressCounts[action]; }
+    bool pressed(int action) const { return pressCounts[action] > 0; }
+
+    void endTick() { memset(pressCounts, 0, sizeof(pressCounts)); }
+    void reset() { heldMask = 0; endTick(); }
+
+private:
+    static const int MAX_BINDINGS = 64;
+    struct Binding { int code; int action; uint8_t type; };
+    Binding bindings[MAX_BINDINGS];
+    int bindingCount = 0;
+    uint32_t heldMask = 0;
+    uint8_t pressCounts[MAX_ACTIONS] = {};
+};
+
+// --- RECORD AND REPLAY ---
+// File: "INPQ", uint32 version, uint32 seed, uint32 payload size and the
+// payload (whatever the game needs to rebuild its start state, e.g. the
+// level), then one record per consumed event:
+//   varint tick delta, uint8 type, uint8 action, uint8 mods, varint code,
+//   and float x, y for everything but keys.
+// A record of type INPUT_END marks the tick the session stopped at. A
+// typical key record takes 5 bytes.
+const uint32_t INPUT_FILE_VERSION = 2;
+const uint8_t INPUT_END = 0xFF;
+
+inline void writeVarint(FILE* file, uint64_t v) {
+    do {
+        uint8_t byte = (uint8_t)(v & 0x7F);
+        v >>= 7;
+        if (v) byte |= 0x80;
+        fputc(byte, file);
+    } while (v);
+}
+
+inline bool readVarint(FILE* file, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(file);
+        if (byte == EOF) return false;
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+class InputRecorder {
+public:
+    ~InputRecorder() { close(); }
+
+    bool open(const std::string& path, uint32_t seed = 0, const std::string& payload = std::string()) {
+        close();
+        file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+        uint32_t size = (uint32_t)payload.size();
+        fwrite("INPQ", 1, 4, file);
+        fwrite(&INPUT_FILE_VERSION, sizeof(INPUT_FILE_VERSION), 1, file);
+        fwrite(&seed, sizeof(seed), 1, file);
+        fwrite(&size, sizeof(size), 1, file);
+        fwrite(payload.data(), 1, size, file);
+        lastTick = 0;
+        return true;
+    }
+
+    void record(uint64_t tick, const InputEvent& event) {
+        if (!file) return;
+        writeVarint(file, tick - lastTick);
+        lastTick = tick;
+        fputc(event.type, file);
+        fputc((uint8_t)event.action, file);
+        fputc((uint8_t)event.mods, file);
+        writeVarint(file, (uint32_t)event.code);
+        if (event.type != INPUT_KEY && event.type != INPUT_END) {
+            fwrite(&event.x, sizeof(event.x), 1, file);
+            fwrite(&event.y, sizeof(event.y), 1, file);
+        }
+    }
+
+    // Marks the end of the session at `tick` and closes the file.
+    void finish(uint64_t tick) {
+        InputEvent end;
+        end.type = INPUT_END;
+        record(tick, end);
+        close();
+    }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+private:
+    FILE* file = nullptr;
+    uint64_t lastTick = 0;
+};
+
+class InputPlayer {
+public:
+    ~InputPlayer() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        char magic[4];
+        uint32_t version = 0, size = 0;
+        bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "INPQ", 4) == 0
+               && fread(&version, sizeof(version), 1, file) == 1 && version == INPUT_FILE_VERSION
+               && fread(&recordedSeed, sizeof(recordedSeed), 1, file) == 1
+               && fread(&size, sizeof(size), 1, file) == 1;
+        if (ok) {
+            recordedPayload.resize(size);
+            ok = fread(&recordedPayload[0], 1, size, file) == size;
+        }
+        if (!ok) {
+            close();
+            return false;
+        }
+        pendingTick = 0;
+        ended = false;
+        advance();
+        return true;
+    }
+
+    // Returns the next event recorded for `tick`; call until it fails.
+    bool next(uint64_t tick, InputEvent& event) {
+        if (!hasPending || pendingTick > tick) return false;
+        if (pending.type == INPUT_END) {
+            ended = true;
+            hasPending = false;
+            return false;
+        }
+        event = pending;
+        advance();
+        return true;
+    }
+
+    // True once the end marker's tick was reached (or the file ran out).
+    bool finished() const { return ended || !hasPending; }
+    uint32_t seed() const { return recordedSeed; }
+    const std::string& payload() const { return recordedPayload; }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+        hasPending = false;
+    }
+
+private:
+    void advance() {
+        hasPending = false;
+        uint64_t delta, code;
+        if (!file || !readVarint(file, delta)) return;
+        int type = fgetc(file), action = fgetc(file), mods = fgetc(file);
+        if (mods == EOF || !readVarint(file, code)) return;
+        pending = InputEvent();
+        pending.type   = (uint8_t)type;
+        pending.action = (int8_t)action;
+        pending.mods   = (int16_t)mods;
+        pending.code   = (int32_t)code;
+        if (pending.type != INPUT_KEY && pending.type != INPUT_END
+            && (fread(&pending.x, sizeof(pending.x), 1, file) != 1 || fread(&pending.y, sizeof(pending.y), 1, file) != 1)) return;
+        pendingTick += delta;
+        hasPending = true;
+    }
+
+    FILE* file = nullptr;
+    bool hasPending = false, ended = false;
+    uint64_t pendingTick = 0;
+    InputEvent pending;
+    uint32_t recordedSeed = 0;
+    std::string recordedPayload;
+};
+
+#endif /* InputQueue_h */
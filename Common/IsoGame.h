@@ -0,0 +1,206 @@
+//
+//  IsoGame.h
+//  Rules of the isometric coin game (grauB) as a pure fixed-tick
+//  simulation: step() advances one tick from a State and an Input and
+//  touches neither GL nor GLFW, so the same code drives the window, the
+//  headless tools and replays. Times are counted in ticks of
+//  1 / ISO_TICK_RATE seconds. Coins live in a sparse set keyed by cell,
+//  so counting, drawing and picking them up cost O(coins), not O(map).
+//
+
+#ifndef IsoGame_h
+#define IsoGame_h
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "SparseSet.h"
+
+// --- TICK TIMING ---
+const int ISO_TICK_RATE       = 60;
+const int MOVE_COOLDOWN_TICKS = 12;   // 0.20 s between steps
+
+// --- TILE IDS WITH GAMEPLAY MEANING ---
+const int TILE_LAVA  = 3;
+const int TILE_WALL  = 5;
+const int TILE_START = 6;
+
+struct TileInfo { int tileIndex; };
+
+struct IsoMap {
+    std::string tileset;
+    int rows = 0, cols = 0;
+    std::vector<TileInfo> tiles;   // row-major
+    SparseSet coins;               // cells (row * cols + col) holding a coin
+
+    TileInfo& at(int row, int col) { return tiles[row * cols + col]; }
+    const TileInfo& at(int row, int col) const { return tiles[row * cols + col]; }
+    bool inside(int row, int col) const { return row >= 0 && row < rows && col >= 0 && col < cols; }
+    bool hasCoin(int row, int col) const { return coins.contains(row * cols + col); }
+};
+
+enum GameStatus { RUNNING, WON, GAMEOVER };
+
+struct GameState {
+    IsoMap level;                  // map as loaded, restored on restart
+    IsoMap map;                    // map being played
+    int playerX = 0, playerY = 0;
+    int prevPlayerX = 0, prevPlayerY = 0;   // position before the last tick, for interpolation
+    int coinCount = 0, totalCoins = 0;    // the round is won when map.coins is empty
+    GameStatus status = RUNNING;
+    uint64_t tick = 0;
+    uint64_t startTick = 0, endTick = 0;
+    uint64_t lastMoveTick = 0;
+    bool moved = false;            // false until the first step of a round
+};
+
+struct GameInput {
+    int dx = 0, dy = 0;            // -1, 0 or 1 on each axis
+    bool restart = false;          // only honoured once the round is over
+};
+
+// --- EVENTS REPORTED BY step() ---
+const unsigned EVENT_MOVED   = 1 << 0;
+const unsigned EVENT_COIN    = 1 << 1;
+const unsigned EVENT_WON     = 1 << 2;
+const unsigned EVENT_LAVA    = 1 << 3;
+const unsigned EVENT_RESTART = 1 << 4;
+
+// Parses the map format of assets/map.txt: tileset file name, "rows cols",
+// then one line per row of tile ids where a 'c' suffix places a coin.
+inline bool loadIsoMap(std::istream& in, IsoMap& map) {
+    std::string line;
+    std::getline(in, map.tileset);
+    if (!map.tileset.empty() && map.tileset.back() == '\r') map.tileset.pop_back();
+    std::getline(in, line);
+    std::istringstream sizeStream(line);
+    map.rows = map.cols = 0;
+    sizeStream >> map.rows >> map.cols;
+    if (map.rows <= 0 || map.cols <= 0) return false;
+    map.tiles.assign(map.rows * map.cols, TileInfo{ 0 });
+    map.coins.init(map.rows * map.cols);
+    for (int i = 0; i < map.rows && std::getline(in, line); ++i) {
+        std::istringstream rowStream(line);
+        std::string token;
+        int j = 0;
+        while (j < map.cols && rowStream >> token) {
+            if (token[0] == '/') continue;
+            if (token.back() == 'c') {
+                map.coins.insert(i * map.cols + j);
+                token.pop_back();
+            }
+            map.at(i, j++).tileIndex = token.empty() ? 0 : std::stoi(token);
+        }
+    }
+    return true;
+}
+
+inline bool loadIsoMap(const std::string& path, IsoMap& map) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Erro ao abrir " << path << std::endl;
+        return false;
+    }
+    return loadIsoMap(file, map);
+}
+
+// Random level for load tests: floor tiles from the tileset, walls and
+// lava with the given densities and a coin on `coinDensity` of the floor.
+inline IsoMap generateIsoMap(int rows, int cols, uint32_t seed, float wallDensity = 0.12f,
+                             float lavaDensity = 0.06f, float coinDensity = 0.08f) {
+    static const int floorTiles[] = { 0, 1, 2, 4 };
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    IsoMap map;
+    map.tileset = "tilesetIso.png";
+    map.rows    = rows;
+    map.cols    = cols;
+    map.tiles.resize(rows * cols);
+    map.coins.init(rows * cols);
+    for (int cell = 0; cell < rows * cols; ++cell) {
+        TileInfo& tile = map.tiles[cell];
+        float roll = chance(rng);
+        if (roll < wallDensity)                    tile.tileIndex = TILE_WALL;
+        else if (roll < wallDensity + lavaDensity) tile.tileIndex = TILE_LAVA;
+        else {
+            tile.tileIndex = floorTiles[rng() % 4];
+            if (chance(rng) < coinDensity) map.coins.insert(cell);
+        }
+    }
+    return map;
+}
+
+// Starts a round on state.level with the player in the middle of the map.
+inline void resetGame(GameState& state) {
+    state.map        = state.level;
+    state.playerX    = state.map.cols / 2;
+    state.playerY    = state.map.rows / 2;
+    if (state.map.inside(state.playerY, state.playerX)) {
+        state.map.at(state.playerY, state.playerX).tileIndex = TILE_START;
+        state.map.coins.erase(state.playerY * state.map.cols + state.playerX);
+    }
+    state.prevPlayerX = state.playerX;
+    state.prevPlayerY = state.playerY;
+    state.coinCount   = 0;
+    state.totalCoins  = (int)state.map.coins.size();
+    state.status      = RUNNING;
+    state.startTick   = state.tick;
+    state.endTick     = state.tick;
+    state.moved       = false;
+}
+
+// Advances the game by one tick and returns the EVENT_* bits that happened.
+inline unsigned step(GameState& state, const GameInput& input) {
+    unsigned events = 0;
+    state.tick++;
+    state.prevPlayerX = state.playerX;
+    state.prevPlayerY = state.playerY;
+
+    if (state.status != RUNNING) {
+        if (input.restart) {
+            resetGame(state);
+            events |= EVENT_RESTART;
+        }
+        return events;
+    }
+    if (input.dx == 0 && input.dy == 0) return events;
+    if (state.moved && state.tick - state.lastMoveTick < MOVE_COOLDOWN_TICKS) return events;
+    int nx = state.playerX + input.dx;
+    int ny = state.playerY + input.dy;
+    if (!state.map.inside(ny, nx)) return events;
+    TileInfo& tile = state.map.at(ny, nx);
+    if (tile.tileIndex == TILE_WALL) return events;
+
+    state.playerX      = nx;
+    state.playerY      = ny;
+    state.lastMoveTick = state.tick;
+    state.moved        = true;
+    events |= EVENT_MOVED;
+    if (state.map.coins.erase(ny * state.map.cols + nx)) {
+        state.coinCount++;
+        events |= EVENT_COIN;
+    }
+    if (state.map.coins.empty()) {
+        state.status  = WON;
+        state.endTick = state.tick;
+        events |= EVENT_WON;
+    }
+    if (tile.tileIndex == TILE_LAVA) {
+        state.status  = GAMEOVER;
+        state.endTick = state.tick;
+        events |= EVENT_LAVA;
+    }
+    return events;
+}
+
+// Seconds between the start of the round and its end (or now, if running).
+inline double roundSeconds(const GameState& state) {
+    uint64_t end = state.status == RUNNING ? state.tick : state.endTick;
+    return (double)(end - state.startTick) / ISO_TICK_RATE;
+}
+
+#endif /* IsoGame_h */
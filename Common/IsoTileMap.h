@@ -0,0 +1,155 @@
+//
+//  IsoTileMap.h
+//  Isometric tilemap drawn by a single full-screen pass. The tile id grid
+//  lives in an integer texture (GL_R8UI, or GL_R16UI when ids don't fit in
+//  a byte); the fragment shader inverts the diamond projection to find the
+//  tile under each pixel and samples the tileset from it. The CPU cost per
+//  frame does not depend on the map size, and changing a tile uploads one
+//  texel.
+//
+//  Tile (row i, col j) covers the screen rectangle
+//    origin + ((j - i) * w/2, (i + j) * h/2)   size (w, h)
+//  and samples column `id` of a single-row tileset, which is the layout
+//  grauB uses for its CPU-built quads.
+//
+
+#ifndef IsoTileMap_h
+#define IsoTileMap_h
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "GLStateCache.h"
+#include "ShaderCache.h"
+#include "SpriteBatch.h"
+#include "UniformBuffers.h"
+
+class IsoTileMap {
+public:
+    void init() {
+        program = buildProgram();
+        glState.useProgram(program);
+        glUniform1i(glGetUniformLocation(program, "tileIds"), 1);
+        glUniform1i(glGetUniformLocation(program, "tileset"), 0);
+        locOrigin      = glGetUniformLocation(program, "origin");
+        locTileSize    = glGetUniformLocation(program, "tileSize");
+        locMapSize     = glGetUniformLocation(program, "mapSize");
+        locTilesPerRow = glGetUniformLocation(program, "tilesPerRow");
+        locHighlight   = glGetUniformLocation(program, "highlight");
+        glUniform2i(locHighlight, -1, -1);
+        glGenVertexArrays(1, &emptyVao);
+        glGenTextures(1, &idTexture);
+        glState.bindTexture(1, GL_TEXTURE_2D, idTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // Replaces the whole grid; `ids` is row-major, rows * cols entries.
+    void upload(int rows, int cols, const std::vector<uint16_t>& ids) {
+        this->rows = rows;
+        this->cols = cols;
+        wide = false;
+        for (uint16_t id : ids) if (id > 0xFF) { wide = true; break; }
+        glState.bindTexture(1, GL_TEXTURE_2D, idTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (wide) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, cols, rows, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, ids.data());
+        } else {
+            std::vector<uint8_t> narrow(ids.begin(), ids.end());
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, cols, rows, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, narrow.data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glState.useProgram(program);
+        glUniform2i(locMapSize, cols, rows);
+    }
+
+    void setTile(int row, int col, uint16_t id) {
+        if (row < 0 || col < 0 || row >= rows || col >= cols) return;
+        glState.bindTexture(1, GL_TEXTURE_2D, idTexture);
+        if (wide) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, col, row, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_SHORT, &id);
+        } else {
+            uint8_t narrow = (uint8_t)id;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, col, row, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &narrow);
+        }
+    }
+
+    void setLayout(glm::vec2 origin, glm::vec2 tileSize, int tilesPerRow) {
+        glState.useProgram(program);
+        glUniform2f(locOrigin, origin.x, origin.y);
+        glUniform2f(locTileSize, tileSize.x, tileSize.y);
+        glUniform1f(locTilesPerRow, (float)tilesPerRow);
+    }
+
+    // Darkens one tile, e.g. the one under the player; pass -1 for none.
+    void setHighlight(int row, int col) {
+        if (row == highlightRow && col == highlightCol) return;
+        highlightRow = row;
+        highlightCol = col;
+        glState.useProgram(program);
+        glUniform2i(locHighlight, col, row);
+    }
+
+    void draw(GLuint tileset, BlendMode blend = BLEND_ALPHA) {
+        glState.useProgram(program);
+        glState.bindTexture(0, GL_TEXTURE_2D, tileset);
+        glState.bindTexture(1, GL_TEXTURE_2D, idTexture);
+        applyBlendMode(blend);
+        glState.bindVertexArray(emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+private:
+    static GLuint buildProgram() {
+        const char* vertexSource = R"(
+            #version 330 core
+            )" FRAME_DATA_GLSL R"(
+            out vec2 ScreenPos;
+            void main() {
+                // one triangle covering the viewport, no vertex buffer needed
+                vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+                ScreenPos = (inverse(projection) * vec4(ndc, 0.0, 1.0)).xy;
+                gl_Position = vec4(ndc, 0.0, 1.0);
+            }
+        )";
+        const char* fragmentSource = R"(
+            #version 330 core
+            in vec2 ScreenPos;
+            out vec4 FragColor;
+            uniform usampler2D tileIds;
+            uniform sampler2D tileset;
+            uniform vec2 origin;
+            uniform vec2 tileSize;
+            uniform ivec2 mapSize;      // cols, rows
+            uniform float tilesPerRow;
+            uniform ivec2 highlight;    // col, row; (-1, -1) for none
+            void main() {
+                // diamond coordinates relative to the top corner of tile (0, 0)
+                vec2 d = (ScreenPos - origin - vec2(tileSize.x * 0.5, 0.0)) / (tileSize * 0.5);
+                int col = int(floor((d.y + d.x) * 0.5));
+                int row = int(floor((d.y - d.x) * 0.5));
+                if (col < 0 || row < 0 || col >= mapSize.x || row >= mapSize.y) discard;
+                uint id = texelFetch(tileIds, ivec2(col, row), 0).r;
+                vec2 corner = origin + vec2(float(col - row), float(col + row)) * tileSize * 0.5;
+                vec2 local  = (ScreenPos - corner) / tileSize;
+                FragColor = texture(tileset, vec2((float(id) + local.x) / tilesPerRow, local.y));
+                if (ivec2(col, row) == highlight) FragColor.rgb *= 0.5;
+            }
+        )";
+        GLuint program = shaderCache.build("isotilemap", vertexSource, fragmentSource);
+        if (program) bindUniformBlocks(program);
+        return program;
+    }
+
+    GLuint program = 0, idTexture = 0, emptyVao = 0;
+    GLint locOrigin = -1, locTileSize = -1, locMapSize = -1, locTilesPerRow = -1, locHighlight = -1;
+    int rows = 0, cols = 0;
+    int highlightRow = -1, highlightCol = -1;
+    bool wide = false;
+};
+
+#endif /* IsoTileMap_h */
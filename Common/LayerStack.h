@@ -0,0 +1,374 @@
+//
+//  LayerStack.h
+//  Parallax layers described in a .layers file. A LayerConfig only reads
+//  the description; a LayerStack draws it: each frame it works out which
+//  part of every layer the camera sees, skips layers that are off screen,
+//  and makes textures resident only once they are needed. Layers larger
+//  than the stream threshold (e.g. 16k-pixel panoramas, beyond many GPUs'
+//  texture size limit) are never loaded whole: they are paged in from a
+//  .vtex file (VirtualTexture.h), written next to the image the first time
+//  it is used, into an atlas of a fixed number of pages.
+//
+//  .layers format, one directive per line ('#' starts a comment):
+//    view <width> <height>           screen size in layer pixels (800 600)
+//    tiles <size> <resident>         page size of streamed layers and how
+//                                    many pages may be resident, which is
+//                                    the video memory budget (1024 24)
+//    stream <pixels>                 layers wider or taller than this are
+//                                    streamed in pages (4096)
+//    layer <name> <image> <rateX> <rateY> [<offsetX> <offsetY>] [none|x|y|xy]
+//                                    back to front; rates are layer pixels
+//                                    moved per camera pixel, the last word
+//                                    says which axes repeat (x by default)
+//
+//  The screen's top left shows layer pixel camera * rate + offset, with y
+//  growing downwards on both. Image paths are used as written, relative
+//  to the working directory like every other asset path.
+//
+
+#ifndef LayerStack_h
+#define LayerStack_h
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+#include "VirtualTexture.h"
+
+enum LayerRepeat : uint8_t { REPEAT_NONE = 0, REPEAT_X = 1, REPEAT_Y = 2, REPEAT_XY = 3 };
+
+struct LayerDesc {
+    std::string name, path;
+    float rateX = 1.0f, rateY = 0.0f;
+    float offsetX = 0.0f, offsetY = 0.0f;
+    uint8_t repeat = REPEAT_X;
+};
+
+// --- DESCRIPTION ---
+struct LayerConfig {
+    float viewWidth = 800.0f, viewHeight = 600.0f;
+    int tileSize = 1024;
+    int maxResidentTiles = 24;
+    int streamThreshold = 4096;
+    std::vector<LayerDesc> layers;   // back to front
+
+    bool load(std::istream& in, const std::string& source = "layers") {
+        std::string line, word;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+            std::istringstream words(line);
+            if (!(words >> word)) continue;
+            bool ok = true;
+            if (word == "view") {
+                ok = (bool)(words >> viewWidth >> viewHeight) && viewWidth > 0.0f && viewHeight > 0.0f;
+            } else if (word == "tiles") {
+                ok = (bool)(words >> tileSize >> maxResidentTiles) && tileSize >= 64 && maxResidentTiles > 0;
+            } else if (word == "stream") {
+                ok = (bool)(words >> streamThreshold) && streamThreshold > 0;
+            } else if (word == "layer") {
+                LayerDesc layer;
+                ok = (bool)(words >> layer.name >> layer.path >> layer.rateX >> layer.rateY) && find(layer.name) < 0;
+                std::string extra;
+                if (ok && words >> extra) {
+                    std::istringstream number(extra);
+                    if (number >> layer.offsetX) {
+                        ok = (bool)(words >> layer.offsetY);
+                        if (!(words >> extra)) extra.clear();
+                    }
+                    if (extra == "none") layer.repeat = REPEAT_NONE;
+                    else if (extra == "x") layer.repeat = REPEAT_X;
+                    else if (extra == "y") layer.repeat = REPEAT_Y;
+                    else if (extra == "xy") layer.repeat = REPEAT_XY;
+                    else if (!extra.empty()) ok = false;
+                }
+                if (ok) layers.push_back(layer);
+            } else {
+                ok = false;
+            }
+            if (!ok) {
+                std::cerr << source << ":" << lineNumber << ": linha invalida: " << line << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            std::cerr << "Erro ao abrir " << path << std::endl;
+            return false;
+        }
+        return load(file, path);
+    }
+
+    int find(const std::string& name) const {
+        for (size_t i = 0; i < layers.size(); ++i) if (layers[i].name == name) return (int)i;
+        return -1;
+    }
+};
+
+// --- RENDERER ---
+class LayerStack {
+public:
+    // Takes the description and reads every image's size (headers only,
+    // nothing is decoded yet); streamed layers are sliced into pages here
+    // if their .vtex is missing or older than the image. Needs no GL context.
+    bool load(const LayerConfig& description) {
+        config = description;
+        layers.assign(config.layers.size(), LayerState());
+        bool ok = true;
+        for (size_t i = 0; i < layers.size(); ++i) {
+            LayerState& l = layers[i];
+            int channels;
+            if (!stbi_info(config.layers[i].path.c_str(), &l.width, &l.height, &channels)) {
+                std::cerr << "Falha ao ler a camada " << config.layers[i].path << std::endl;
+                l.failed = true;
+                ok = false;
+                continue;
+            }
+            l.streamed = l.width > config.streamThreshold || l.height > config.streamThreshold;
+            if (l.streamed && !virtualTextureUpToDate(config.layers[i].path, pagePath(i), config.tileSize)) {
+                std::cout << "Gerando paginas de " << config.layers[i].path << std::endl;
+                if (!importVirtualTexture(config.layers[i].path, pagePath(i), config.tileSize)) {
+                    l.failed = true;
+                    ok = false;
+                }
+            }
+        }
+        return ok;
+    }
+
+    bool load(const std::string& path) {
+        LayerConfig description;
+        return description.load(path) && load(description);
+    }
+
+    // Needs a current GL context; call after load().
+    void init(GLenum textureFilter = GL_LINEAR) {
+        filter = textureFilter;
+        program = buildProgram();
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "image"), 0);
+        locView   = glGetUniformLocation(program, "viewSize");
+        locScreen = glGetUniformLocation(program, "screenRect");
+        locUV     = glGetUniformLocation(program, "uvRect");
+        glGenVertexArrays(1, &emptyVao);
+        bool streaming = false;
+        for (const LayerState& l : layers) streaming = streaming || (l.streamed && !l.failed);
+        if (!streaming) return;
+        pages.init(config.tileSize, config.maxResidentTiles, filter);
+        for (size_t i = 0; i < layers.size(); ++i) {
+            LayerState& l = layers[i];
+            if (!l.streamed || l.failed) continue;
+            l.source = pages.addSource(pagePath(i));
+            l.failed = l.source < 0;
+        }
+    }
+
+    // Works out what the camera sees and makes it resident. Whole-image
+    // layers are uploaded right away; pages of streamed layers are read in
+    // the background, visible ones first, then those within half a page of
+    // the view, and their area is drawn from the layer's low-resolution copy
+    // until they arrive.
+    void update(float cameraX, float cameraY) {
+        if (pages.capacity() > 0) pages.beginFrame();
+        pieces.clear();
+        visibleLayers.clear();
+        for (size_t i = 0; i < layers.size(); ++i) {
+            const LayerDesc& desc = config.layers[i];
+            LayerState& l = layers[i];
+            if (l.failed) continue;
+            float x0 = cameraX * desc.rateX + desc.offsetX;
+            float y0 = cameraY * desc.rateY + desc.offsetY;
+            int tileW = l.streamed ? config.tileSize : l.width;
+            int tileH = l.streamed ? config.tileSize : l.height;
+            spans(x0, config.viewWidth, l.width, tileW, desc.repeat & REPEAT_X, spansX);
+            spans(y0, config.viewHeight, l.height, tileH, desc.repeat & REPEAT_Y, spansY);
+            if (spansX.empty() || spansY.empty()) continue;
+            visibleLayers.push_back((int)i);
+            if (!l.streamed && !makeResident((int)i)) continue;
+            for (const Span& sy : spansY) {
+                for (const Span& sx : spansX) {
+                    Piece p;
+                    p.screen[0] = sx.screen; p.screen[1] = sy.screen;
+                    p.screen[2] = sx.end - sx.begin; p.screen[3] = sy.end - sy.begin;
+                    int slot = l.streamed ? pages.lookup(l.source, sx.index, sy.index) : -1;
+                    if (slot >= 0) {
+                        p.texture = pages.atlas();
+                        pages.slotUV(slot, sx.begin, sy.begin, sx.end, sy.end, p.uv);
+                    } else {
+                        // whole image, or the fallback copy of a page not read yet
+                        if (l.streamed) pages.want(l.source, sx.index, sy.index, true);
+                        p.texture = l.streamed ? pages.fallback(l.source) : l.texture;
+                        float left = (float)sx.index * tileW, top = (float)sy.index * tileH;
+                        p.uv[0] = (left + sx.begin) / l.width; p.uv[1] = (top + sy.begin) / l.height;
+                        p.uv[2] = (left + sx.end) / l.width;   p.uv[3] = (top + sy.end) / l.height;
+                    }
+                    pieces.push_back(p);
+                }
+            }
+            if (l.streamed) {
+                float margin = 0.5f * config.tileSize;
+                spans(x0 - margin, config.viewWidth + 2.0f * margin, l.width, tileW, desc.repeat & REPEAT_X, spansX);
+                spans(y0 - margin, config.viewHeight + 2.0f * margin, l.height, tileH, desc.repeat & REPEAT_Y, spansY);
+                for (const Span& sy : spansY)
+                    for (const Span& sx : spansX) pages.want(l.source, sx.index, sy.index, false);
+            }
+        }
+        if (pages.capacity() > 0) pages.endFrame();
+    }
+
+    // Draws what update() found, back to front, over the whole viewport
+    // with the caller's blend state.
+    void draw() {
+        glUseProgram(program);
+        glUniform2f(locView, config.viewWidth, config.viewHeight);
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(emptyVao);
+        for (const Piece& p : pieces) {
+            glBindTexture(GL_TEXTURE_2D, p.texture);
+            glUniform4fv(locScreen, 1, p.screen);
+            glUniform4fv(locUV, 1, p.uv);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    }
+
+    const LayerConfig& description() const { return config; }
+    // Layers drawn by the last update(), back to front.
+    const std::vector<int>& visible() const { return visibleLayers; }
+    const PageCache& pageCache() const { return pages; }
+    int drawCount() const { return (int)pieces.size(); }
+
+    void destroy() {
+        for (LayerState& l : layers) {
+            if (l.texture) glDeleteTextures(1, &l.texture);
+            l.texture = 0;
+        }
+        pages.destroy();
+        glDeleteVertexArrays(1, &emptyVao);
+        glDeleteProgram(program);
+        emptyVao = program = 0;
+    }
+
+private:
+    struct LayerState {
+        int width = 0, height = 0;
+        bool streamed = false, failed = false;
+        GLuint texture = 0;   // whole-image layers
+        int source = -1;      // streamed layers, in the page cache
+    };
+    // Part of the view along one axis: tile `index` from `begin` to `end`
+    // (pixels inside the tile), placed at `screen` pixels from the view's edge.
+    struct Span {
+        int index;
+        float begin, end, screen;
+    };
+    struct Piece {
+        GLuint texture;
+        float screen[4];   // x, y, width, height in view pixels
+        float uv[4];       // u0, v0, u1, v1
+    };
+
+    static void spans(float start, float length, int size, int tile, bool repeat, std::vector<Span>& out) {
+        out.clear();
+        double lo = start, hi = (double)start + length;
+        if (!repeat) {
+            lo = std::max(lo, 0.0);
+            hi = std::min(hi, (double)size);
+        }
+        int tileCount = (size + tile - 1) / tile;
+        for (double pos = lo; pos < hi && out.size() < 256; ) {
+            double period = repeat ? std::floor(pos / size) * size : 0.0;
+            double local = std::min(pos - period, (double)size - 1e-3);
+            int index = std::min((int)(local / tile), tileCount - 1);
+            double next = std::min(hi, period + std::min((double)(index + 1) * tile, (double)size));
+            out.push_back(Span{ index, (float)(local - (double)index * tile), (float)(next - period - (double)index * tile),
+                                (float)(pos - start) });
+            pos = next;
+        }
+    }
+
+    static unsigned char* decode(const std::string& path) {
+        int w, h, channels;
+        stbi_set_flip_vertically_on_load(false);
+        unsigned char* data = stbi_load(path.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+        if (!data) std::cerr << "Falha ao carregar a camada " << path << std::endl;
+        return data;
+    }
+
+    GLuint createTexture(int width, int height, const unsigned char* data) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        return texture;
+    }
+
+    // Whole-image layers are uploaded the first time they are seen and the
+    // decoded pixels are dropped right after.
+    bool makeResident(int layer) {
+        LayerState& l = layers[layer];
+        if (l.texture) return true;
+        unsigned char* data = decode(config.layers[layer].path);
+        if (!data) {
+            l.failed = true;
+            return false;
+        }
+        l.texture = createTexture(l.width, l.height, data);
+        stbi_image_free(data);
+        return true;
+    }
+
+    std::string pagePath(size_t layer) const { return config.layers[layer].path + ".vtex"; }
+
+    static GLuint buildProgram() {
+        const char* vertexSource = R"(
+            #version 330 core
+            uniform vec2 viewSize;
+            uniform vec4 screenRect;   // x, y, width, height in view pixels, y down
+            uniform vec4 uvRect;
+            out vec2 TexCoord;
+            void main() {
+                vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+                vec2 pos = (screenRect.xy + corner * screenRect.zw) / viewSize;
+                TexCoord = mix(uvRect.xy, uvRect.zw, corner);
+                gl_Position = vec4(pos.x * 2.0 - 1.0, 1.0 - pos.y * 2.0, 0.0, 1.0);
+            }
+        )";
+        const char* fragmentSource = R"(
+            #version 330 core
+            in vec2 TexCoord;
+            out vec4 FragColor;
+            uniform sampler2D image;
+            void main() { FragColor = texture(image, TexCoord); }
+        )";
+        return shaderCache.build("layerstack", vertexSource, fragmentSource);
+    }
+
+    LayerConfig config;
+    std::vector<LayerState> layers;
+    std::vector<Piece> pieces;
+    std::vector<Span> spansX, spansY;
+    std::vector<int> visibleLayers;
+    GLuint program = 0, emptyVao = 0;
+    GLint locView = -1, locScreen = -1, locUV = -1;
+    GLenum filter = GL_LINEAR;
+    PageCache pages;
+};
+
+#endif /* LayerStack_h */
@@ -1,7 +0,0 @@
-typedef struct Layer {
-		float z;
-		unsigned int tid;
-		char * filename;
-		float offsetx, offsety, ratex, ratey;
-	
-} Layer;
\ No newline at end of file
@@ -0,0 +1,201 @@
+//
+//  ParallaxCompositor.h
+//  Parallax background drawn in one full-screen pass. All layers are
+//  slices of one GL_TEXTURE_2D_ARRAY (so they must share a size); the
+//  fragment shader walks them front to back, places each at
+//  camera * rate + offset, wraps with GL_REPEAT on the axes the layer
+//  repeats on and stops as soon as the pixel is opaque. Every pixel is
+//  written once instead of once per layer, and the sky behind a solid
+//  foreground is never sampled.
+//
+//      LayerConfig config;
+//      config.load("../assets/layers/fundo.layers");
+//      ParallaxCompositor parallax;
+//      parallax.init(config);
+//      ...
+//      parallax.draw(cameraX);
+//
+//  Layers, rates, offsets and repeat modes come from a .layers file (see
+//  LayerStack.h) and the camera is in image pixels, as for a LayerStack,
+//  but the screen always shows one whole image. init() refuses layers of
+//  different sizes and layers the config would stream (over its stream
+//  threshold or GL_MAX_TEXTURE_SIZE); draw those with a LayerStack, whose
+//  view should then be the image size to show the same. Uses plain GL calls, like
+//  the programs that draw it; the output is opaque, so blending state
+//  doesn't matter.
+//
+
+#ifndef ParallaxCompositor_h
+#define ParallaxCompositor_h
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "LayerStack.h"
+#include "ShaderCache.h"
+
+class ParallaxCompositor {
+public:
+    static const int MAX_LAYERS = 16;
+
+    // Loads the config's layers (back to front) as array slices, expanded
+    // to RGBA. Returns false, before creating anything, if the layers don't
+    // fit one texture array; and if an image fails to load.
+    bool init(const LayerConfig& config, GLenum filter = GL_LINEAR) {
+        const std::vector<LayerDesc>& descs = config.layers;
+        if (descs.empty() || descs.size() > MAX_LAYERS) {
+            std::cerr << "Numero de camadas invalido: " << descs.size() << std::endl;
+            return false;
+        }
+        GLint maxTexture = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+        int limit = std::min((int)maxTexture, config.streamThreshold);
+        for (size_t i = 0; i < descs.size(); ++i) {
+            int w, h, channels;
+            if (!stbi_info(descs[i].path.c_str(), &w, &h, &channels)) {
+                std::cerr << "Falha ao ler a camada " << descs[i].path << std::endl;
+                return false;
+            }
+            if (i == 0) { width = w; height = h; }
+            if (w != width || h != height || w > limit || h > limit) {
+                std::cerr << "Camada " << descs[i].path << " (" << w << "x" << h
+                          << ") nao cabe na textura das camadas" << std::endl;
+                return false;
+            }
+        }
+        layers = (int)descs.size();
+        program = buildProgram();
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "layers"), 0);
+        glUniform1i(glGetUniformLocation(program, "layerCount"), layers);
+        locCamera     = glGetUniformLocation(program, "camera");
+        locPlacement  = glGetUniformLocation(program, "layerPlacement");
+        locBackground = glGetUniformLocation(program, "background");
+        int repeat[MAX_LAYERS] = {};
+        for (int i = 0; i < layers; ++i) {
+            const LayerDesc& d = descs[i];
+            float* p = &placement[4 * i];
+            p[0] = d.rateX; p[1] = d.rateY; p[2] = d.offsetX; p[3] = d.offsetY;
+            repeat[i] = d.repeat;
+        }
+        glUniform4fv(locPlacement, layers, placement);
+        glUniform1iv(glGetUniformLocation(program, "layerRepeat"), layers, repeat);
+        glGenVertexArrays(1, &emptyVao);
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        // flipped, so v grows upwards like the screen coordinates
+        stbi_set_flip_vertically_on_load(true);
+        bool ok = true;
+        for (int i = 0; i < layers && ok; ++i) {
+            int w, h, channels;
+            unsigned char* data = stbi_load(descs[i].path.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+            if (!data) {
+                std::cerr << "Falha ao carregar a camada " << descs[i].path << std::endl;
+                ok = false;
+                break;
+            }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            stbi_image_free(data);
+        }
+        stbi_set_flip_vertically_on_load(false);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glUniform2f(glGetUniformLocation(program, "imageSize"), (float)width, (float)height);
+        return ok;
+    }
+
+    // Overrides the scroll rate a layer got from the config.
+    void setRate(int layer, float rateX, float rateY) {
+        if (layer < 0 || layer >= layers) return;
+        placement[4 * layer] = rateX;
+        placement[4 * layer + 1] = rateY;
+        glUseProgram(program);
+        glUniform4fv(locPlacement, layers, placement);
+    }
+
+    // Shown where every layer is transparent.
+    void setBackground(float r, float g, float b) {
+        glUseProgram(program);
+        glUniform3f(locBackground, r, g, b);
+    }
+
+    // Covers the viewport; draw it first instead of clearing the color buffer.
+    void draw(float cameraX, float cameraY = 0.0f) {
+        glUseProgram(program);
+        glUniform2f(locCamera, cameraX, cameraY);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glBindVertexArray(emptyVao);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    int layerCount() const { return layers; }
+    int imageWidth() const { return width; }
+    int imageHeight() const { return height; }
+
+    void destroy() {
+        glDeleteTextures(1, &texture);
+        glDeleteVertexArrays(1, &emptyVao);
+        glDeleteProgram(program);
+        texture = emptyVao = program = 0;
+    }
+
+private:
+    static GLuint buildProgram() {
+        const char* vertexSource = R"(
+            #version 330 core
+            out vec2 ScreenUV;
+            void main() {
+                // one triangle covering the viewport, no vertex buffer needed
+                vec2 ndc = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+                ScreenUV = ndc * 0.5 + 0.5;
+                gl_Position = vec4(ndc, 0.0, 1.0);
+            }
+        )";
+        const char* fragmentSource = R"(
+            #version 330 core
+            in vec2 ScreenUV;
+            out vec4 FragColor;
+            uniform sampler2DArray layers;
+            uniform int layerCount;
+            uniform vec4 layerPlacement[16];   // rate.xy, offset.xy in pixels
+            uniform int layerRepeat[16];       // bit 0: x, bit 1: y
+            uniform vec2 imageSize;
+            uniform vec2 camera;
+            uniform vec3 background;
+            void main() {
+                // front to back "under" compositing: the accumulated colour is
+                // premultiplied, and layers behind an opaque pixel are skipped
+                vec4 acc = vec4(0.0);
+                for (int i = layerCount - 1; i >= 0; --i) {
+                    // layer pixels grow downwards, v grows upwards
+                    vec2 shift = (camera * layerPlacement[i].xy + layerPlacement[i].zw) / imageSize;
+                    vec2 uv = ScreenUV + vec2(shift.x, -shift.y);
+                    if ((layerRepeat[i] & 1) == 0 && (uv.x < 0.0 || uv.x >= 1.0)) continue;
+                    if ((layerRepeat[i] & 2) == 0 && (uv.y < 0.0 || uv.y >= 1.0)) continue;
+                    vec4 c = textureLod(layers, vec3(uv, float(i)), 0.0);
+                    acc += (1.0 - acc.a) * vec4(c.rgb * c.a, c.a);
+                    if (acc.a >= 0.996) break;
+                }
+                FragColor = vec4(acc.rgb + (1.0 - acc.a) * background, 1.0);
+            }
+        )";
+        return shaderCache.build("parallax", vertexSource, fragmentSource);
+    }
+
+    GLuint program = 0, texture = 0, emptyVao = 0;
+    GLint locCamera = -1, locPlacement = -1, locBackground = -1;
+    int layers = 0, width = 0, height = 0;
+    float placement[4 * MAX_LAYERS];
+};
+
+#endif /* ParallaxCompositor_h */
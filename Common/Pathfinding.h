@@ -0,0 +1,350 @@
+//
+//  Pathfinding.h
+//  Shortest paths over a flat grid of tile ids (the row-major layout of
+//  IsoMap and TileMap). Each tile id has a movement cost, or PATH_BLOCKED.
+//
+//  - A* with 4 or 8 neighbours, a binary heap with decrease-key and a
+//    node pool sized once per grid; searches stamp nodes with a search id
+//    instead of clearing the pool.
+//  - Jump Point Search for 8-neighbour grids where every walkable tile
+//    costs the same; other grids fall back to A*.
+//
+//  Diagonal steps never cut corners: both orthogonal neighbours must be
+//  walkable. Paths are returned as cell indices (row * width + col) from
+//  start to goal, both included.
+//
+
+#ifndef Pathfinding_h
+#define Pathfinding_h
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+const float PATH_BLOCKED = -1.0f;
+const float PATH_SQRT2   = 1.41421356f;
+
+// Flat-grid offsets in the order of the DIRECTION_* constants of TilemapView.
+enum PathNeighbours { NEIGHBOURS_4 = 4, NEIGHBOURS_8 = 8 };
+const int PATH_DX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+const int PATH_DY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+struct PathStats {
+    unsigned expanded = 0;   // nodes popped from the open list
+    unsigned pushed   = 0;   // nodes inserted or improved
+    float cost        = 0.0f;
+};
+
+class Pathfinder {
+public:
+    Pathfinder() {
+        for (int i = 0; i < 256; ++i) costs[i] = 1.0f;
+    }
+
+    // Points the pathfinder at a grid; the pool is reallocated only when
+    // the size changes. The tile array must outlive the searches.
+    void setGrid(const uint8_t* tiles, int width, int height) {
+        this->tiles  = tiles;
+        this->width  = width;
+        this->height = height;
+        if ((int)nodes.size() != width * height) {
+            nodes.assign(width * height, Node());
+            heap.reserve(width * height);
+            search = 0;
+        }
+    }
+
+    void setCost(uint8_t tile, float cost) {
+        costs[tile] = cost;
+        uniformKnown = false;
+    }
+
+    void setNeighbours(PathNeighbours neighbours) { this->neighbours = neighbours; }
+
+    bool walkable(int x, int y) const {
+        return x >= 0 && y >= 0 && x < width && y < height && costs[tiles[y * width + x]] >= 0.0f;
+    }
+
+    // A* from (sx, sy) to (gx, gy). Returns false if the goal is unreachable.
+    bool findPath(int sx, int sy, int gx, int gy, std::vector<int>& path) {
+        path.clear();
+        stats = PathStats();
+        if (!walkable(sx, sy) || !walkable(gx, gy)) return false;
+        beginSearch();
+        goalX = gx;
+        goalY = gy;
+        minCost = minimumCost();
+        int start = sy * width + sx, goal = gy * width + gx;
+        open(start, -1, 0.0f);
+        while (!heap.empty()) {
+            int current = pop();
+            if (current == goal) return buildPath(goal, path, false);
+            int cx = current % width, cy = current / width;
+            float g = nodes[current].g;
+            for (int d = 0; d < neighbours; ++d) {
+                int nx = cx + PATH_DX[d], ny = cy + PATH_DY[d];
+                if (!walkable(nx, ny)) continue;
+                if (d >= 4 && (!walkable(cx + PATH_DX[d], cy) || !walkable(cx, cy + PATH_DY[d]))) continue;
+                int next = ny * width + nx;
+                float step = costs[tiles[next]] * (d >= 4 ? PATH_SQRT2 : 1.0f);
+                open(next, current, g + step);
+            }
+        }
+        return false;
+    }
+
+    // Jump Point Search; same result cost as 8-neighbour A* on uniform grids.
+    bool findPathJPS(int sx, int sy, int gx, int gy, std::vector<int>& path) {
+        if (neighbours != NEIGHBOURS_8 || !isUniform()) return findPath(sx, sy, gx, gy, path);
+        path.clear();
+        stats = PathStats();
+        if (!walkable(sx, sy) || !walkable(gx, gy)) return false;
+        beginSearch();
+        goalX = gx;
+        goalY = gy;
+        minCost = uniformCost;
+        int start = sy * width + sx, goal = gy * width + gx;
+        open(start, -1, 0.0f);
+        while (!heap.empty()) {
+            int current = pop();
+            if (current == goal) return buildPath(goal, path, true);
+            int cx = current % width, cy = current / width;
+            int parent = nodes[current].parent;
+            int dirs[8][2];
+            int count = prunedDirections(cx, cy, parent, dirs);
+            for (int k = 0; k < count; ++k) {
+                int jumpPoint = jump(cx + dirs[k][0], cy + dirs[k][1], dirs[k][0], dirs[k][1]);
+                if (jumpPoint < 0) continue;
+                int jx = jumpPoint % width, jy = jumpPoint / width;
+                open(jumpPoint, current, nodes[current].g + octile(abs(jx - cx), abs(jy - cy)) * uniformCost);
+            }
+        }
+        return false;
+    }
+
+    const PathStats& lastStats() const { return stats; }
+
+private:
+    struct Node {
+        float g = 0.0f, f = 0.0f;
+        int parent = -1;
+        int heapIndex = -1;     // -1 once closed
+        uint32_t search = 0;    // search that last touched the node
+    };
+
+    void beginSearch() {
+        heap.clear();
+        if (++search == 0) {    // wrapped: stale stamps could collide
+            for (Node& node : nodes) node.search = 0;
+            search = 1;
+        }
+    }
+
+    static float octile(int dx, int dy) {
+        return dx < dy ? dx * PATH_SQRT2 + (dy - dx) : dy * PATH_SQRT2 + (dx - dy);
+    }
+
+    float heuristic(int index) const {
+        int dx = abs(index % width - goalX), dy = abs(index / width - goalY);
+        if (neighbours == NEIGHBOURS_4) return (dx + dy) * minCost;
+        return octile(dx, dy) * minCost;
+    }
+
+    float minimumCost() const {
+        float best = 0.0f;
+        bool found = false;
+        for (int i = 0; i < 256; ++i)
+            if (costs[i] >= 0.0f && (!found || costs[i] < best)) { best = costs[i]; found = true; }
+        return best;
+    }
+
+    // True when every walkable tile id has the same cost.
+    bool isUniform() {
+        if (uniformKnown) return uniform;
+        uniform = true;
+        uniformCost = -1.0f;
+        for (int i = 0; i < 256 && uniform; ++i) {
+            if (costs[i] < 0.0f) continue;
+            if (uniformCost < 0.0f) uniformCost = costs[i];
+            else if (costs[i] != uniformCost) uniform = false;
+        }
+        uniformKnown = true;
+        return uniform;
+    }
+
+    // Inserts a node or lowers its cost; closed nodes are left alone.
+    void open(int index, int parent, float g) {
+        Node& node = nodes[index];
+        if (node.search == search) {
+            if (node.heapIndex < 0 || g >= node.g) return;
+            node.g      = g;
+            node.f      = g + heuristic(index);
+            node.parent = parent;
+            siftUp(node.heapIndex);
+        } else {
+            node.search    = search;
+            node.g         = g;
+            node.f         = g + heuristic(index);
+            node.parent    = parent;
+            node.heapIndex = (int)heap.size();
+            heap.push_back(index);
+            siftUp(node.heapIndex);
+        }
+        stats.pushed++;
+    }
+
+    int pop() {
+        int top = heap[0];
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            nodes[last].heapIndex = 0;
+            siftDown(0);
+        }
+        nodes[top].heapIndex = -1;
+        stats.expanded++;
+        return top;
+    }
+
+    // Orders by f; ties go to the node with the larger g, i.e. the one
+    // closer to the goal, which keeps open grids from expanding every tie.
+    bool before(int a, int b) const {
+        const Node& na = nodes[a];
+        const Node& nb = nodes[b];
+        if (na.f < nb.f - 1e-4f) return true;
+        if (na.f > nb.f + 1e-4f) return false;
+        return na.g > nb.g;
+    }
+
+    void siftUp(int i) {
+        int index = heap[i];
+        while (i > 0) {
+            int up = (i - 1) / 2;
+            if (!before(index, heap[up])) break;
+            heap[i] = heap[up];
+            nodes[heap[i]].heapIndex = i;
+            i = up;
+        }
+        heap[i] = index;
+        nodes[index].heapIndex = i;
+    }
+
+    void siftDown(int i) {
+        int index = heap[i];
+        int n = (int)heap.size();
+        for (;;) {
+            int child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && before(heap[child + 1], heap[child])) child++;
+            if (!before(heap[child], index)) break;
+            heap[i] = heap[child];
+            nodes[heap[i]].heapIndex = i;
+            i = child;
+        }
+        heap[i] = index;
+        nodes[index].heapIndex = i;
+    }
+
+    // Directions worth following from a jump point, given where we came from.
+    int prunedDirections(int x, int y, int parent, int dirs[8][2]) const {
+        int count = 0;
+        if (parent < 0) {
+            for (int d = 0; d < 8; ++d) {
+                if (d >= 4 && (!walkable(x + PATH_DX[d], y) || !walkable(x, y + PATH_DY[d]))) continue;
+                if (!walkable(x + PATH_DX[d], y + PATH_DY[d])) continue;
+                dirs[count][0] = PATH_DX[d];
+                dirs[count][1] = PATH_DY[d];
+                count++;
+            }
+            return count;
+        }
+        int px = parent % width, py = parent / width;
+        int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+        auto add = [&](int ax, int ay) { dirs[count][0] = ax; dirs[count][1] = ay; count++; };
+        if (dx != 0 && dy != 0) {
+            bool vertical = walkable(x, y + dy), horizontal = walkable(x + dx, y);
+            if (vertical)   add(0, dy);
+            if (horizontal) add(dx, 0);
+            if (vertical && horizontal && walkable(x + dx, y + dy)) add(dx, dy);
+        } else if (dx != 0) {
+            bool next = walkable(x + dx, y), up = walkable(x, y - 1), down = walkable(x, y + 1);
+            if (next) {
+                add(dx, 0);
+                if (up && walkable(x + dx, y - 1))   add(dx, -1);
+                if (down && walkable(x + dx, y + 1)) add(dx, 1);
+            }
+            if (up)   add(0, -1);
+            if (down) add(0, 1);
+        } else {
+            bool next = walkable(x, y + dy), left = walkable(x - 1, y), right = walkable(x + 1, y);
+            if (next) {
+                add(0, dy);
+                if (left && walkable(x - 1, y + dy))  add(-1, dy);
+                if (right && walkable(x + 1, y + dy)) add(1, dy);
+            }
+            if (left)  add(-1, 0);
+            if (right) add(1, 0);
+        }
+        return count;
+    }
+
+    // Walks from (x, y) in direction (dx, dy) until it finds the goal, a
+    // node with a forced neighbour, or a wall. Diagonal walks probe the two
+    // straight directions at every step; straight walks are plain loops.
+    int jump(int x, int y, int dx, int dy) const {
+        for (;;) {
+            if (!walkable(x, y)) return -1;
+            if (x == goalX && y == goalY) return y * width + x;
+            if (dx != 0 && dy != 0) {
+                if (jump(x + dx, y, dx, 0) >= 0 || jump(x, y + dy, 0, dy) >= 0) return y * width + x;
+                if (!walkable(x + dx, y) || !walkable(x, y + dy)) return -1;
+            } else if (dx != 0) {
+                if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+                    (walkable(x, y + 1) && !walkable(x - dx, y + 1))) return y * width + x;
+            } else {
+                if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+                    (walkable(x + 1, y) && !walkable(x + 1, y - dy))) return y * width + x;
+            }
+            x += dx;
+            y += dy;
+        }
+    }
+
+    // Follows parents back from the goal; jump point paths are expanded
+    // into every cell along each straight or diagonal segment.
+    bool buildPath(int goal, std::vector<int>& path, bool jumpPoints) {
+        stats.cost = nodes[goal].g;
+        for (int index = goal; index >= 0; index = nodes[index].parent) {
+            int parent = nodes[index].parent;
+            path.push_back(index);
+            if (!jumpPoints || parent < 0) continue;
+            int x = index % width, y = index / width;
+            int px = parent % width, py = parent / width;
+            int dx = (px > x) - (px < x), dy = (py > y) - (py < y);
+            for (x += dx, y += dy; x != px || y != py; x += dx, y += dy) path.push_back(y * width + x);
+        }
+        for (size_t i = 0, j = path.size() - 1; i < j; ++i, --j) {
+            int swap = path[i];
+            path[i] = path[j];
+            path[j] = swap;
+        }
+        return true;
+    }
+
+    const uint8_t* tiles = nullptr;
+    int width = 0, height = 0;
+    float costs[256];
+    PathNeighbours neighbours = NEIGHBOURS_4;
+    bool uniformKnown = false, uniform = true;
+    float uniformCost = 1.0f;
+    int goalX = 0, goalY = 0;
+    float minCost = 1.0f;
+    std::vector<Node> nodes;
+    std::vector<int> heap;
+    uint32_t search = 0;
+    PathStats stats;
+};
+
+#endif /* Pathfinding_h */
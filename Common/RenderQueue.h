@@ -0,0 +1,111 @@
+//
+//  RenderQueue.h
+//  Deferred 2D draw submission. Draw functions submit textured quads with
+//  a 64-bit sort key; flush() radix-sorts the keys and replays the commands
+//  into a SpriteBatch, so runs of commands that share program, texture and
+//  blend mode end up in a single draw.
+//
+//  Key layout (most significant first):
+//    layer   4 bits   coarse pass (ground, objects, UI...)
+//    depth  24 bits   back-to-front order; leave 0 when order does not matter
+//    program 8 bits
+//    texture 24 bits
+//    blend   4 bits
+//  Layers that don't overlap pass depth 0, so their commands end up grouped
+//  by state; layers that need painter's order pass a depth and only commands
+//  of equal depth are grouped.
+//
+
+#ifndef RenderQueue_h
+#define RenderQueue_h
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+#include "SpriteBatch.h"
+
+struct QueueStats {
+    unsigned commands = 0;
+    unsigned draws    = 0;
+};
+
+class RenderQueue {
+public:
+    // Programs drawn through the queue use the SpriteBatch vertex layout.
+    void init(int maxQuadsPerDraw = 16384) {
+        batch.init(maxQuadsPerDraw);
+    }
+
+    static uint64_t makeKey(unsigned layer, unsigned depth, GLuint program, GLuint texture, BlendMode blend) {
+        return (uint64_t)(layer & 0xF) << 60 | (uint64_t)(depth & 0xFFFFFF) << 36 |
+               (uint64_t)(program & 0xFF) << 28 | (uint64_t)(texture & 0xFFFFFF) << 4 | (uint64_t)(blend & 0xF);
+    }
+
+    void submit(uint64_t key, GLuint program, GLuint texture, BlendMode blend, const SpriteQuad& quad) {
+        Command cmd;
+        cmd.program = program;
+        cmd.texture = texture;
+        cmd.blend   = blend;
+        cmd.quad    = quad;
+        keys.push_back(key);
+        commands.push_back(cmd);
+    }
+
+    // Sorts and draws everything submitted since the last flush.
+    void flush() {
+        frameStats.commands += (unsigned)commands.size();
+        sortByKey();
+        batch.beginFrame();
+        for (uint32_t index : order) {
+            const Command& cmd = commands[index];
+            batch.draw(cmd.program, cmd.texture, cmd.blend, cmd.quad);
+        }
+        batch.endFrame();
+        frameStats.draws += batch.takeStats().draws;
+        keys.clear();
+        commands.clear();
+    }
+
+    // Returns the counters of the frame that just ended and starts a new one.
+    QueueStats endFrame() {
+        QueueStats frame = frameStats;
+        frameStats = QueueStats();
+        return frame;
+    }
+
+    void destroy() { batch.destroy(); }
+
+private:
+    struct Command {
+        GLuint program, texture;
+        BlendMode blend;
+        SpriteQuad quad;
+    };
+
+    // LSD radix sort of (key, index) pairs, 8 bits per pass. Passes where
+    // every key has the same byte are skipped, which is most of them for
+    // keys built by makeKey. Stable, so equal keys keep submission order.
+    void sortByKey() {
+        size_t n = keys.size();
+        order.resize(n);
+        scratch.resize(n);
+        for (size_t i = 0; i < n; ++i) order[i] = (uint32_t)i;
+        for (int shift = 0; shift < 64; shift += 8) {
+            size_t count[256] = { 0 };
+            for (size_t i = 0; i < n; ++i) count[(keys[order[i]] >> shift) & 0xFF]++;
+            if (n == 0 || count[(keys[order[0]] >> shift) & 0xFF] == n) continue;
+            size_t sum = 0;
+            for (int b = 0; b < 256; ++b) { size_t c = count[b]; count[b] = sum; sum += c; }
+            for (size_t i = 0; i < n; ++i) scratch[count[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+            order.swap(scratch);
+        }
+    }
+
+    SpriteBatch batch;
+    std::vector<uint64_t> keys;
+    std::vector<Command> commands;
+    std::vector<uint32_t> order, scratch;
+    QueueStats frameStats;
+};
+
+#endif /* RenderQueue_h */
@@ -0,0 +1,148 @@
+//
+//  Replay.h
+//  Record/replay runner for the fixed-tick programs, so performance can be
+//  compared between builds on the exact same workload.
+//
+//    prog --record ARQ             plays normally and saves seed, start
+//                                  state and every consumed input event
+//    prog --replay ARQ [--headless]
+//                                  replays ARQ with simulated time (each
+//                                  frame advances exactly one tick, vsync
+//                                  off), in a hidden window if headless,
+//                                  then prints frame time statistics
+//
+//  The program feeds window events through push(), consumes them per tick
+//  with consume(), and takes its frame delta from frameDelta(); when
+//  replaying, live events are ignored and the recording is used instead.
+//  GLFW-free: the program applies headless() / replaying() to its window.
+//
+
+#ifndef Replay_h
+#define Replay_h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "InputQueue.h"
+
+// --- FRAME TIME STATISTICS ---
+class FrameStats {
+public:
+    void add(double seconds) { samples.push_back(seconds); }
+    size_t count() const { return samples.size(); }
+
+    // One line that is easy to diff between builds.
+    void print(const char* label) const {
+        if (samples.empty()) {
+            printf("%s: nenhum quadro\n", label);
+            return;
+        }
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double s : sorted) total += s;
+        auto pct = [&](double p) { return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))] * 1000.0; };
+        printf("%s: %zu quadros | media %.3f ms | p50 %.3f | p95 %.3f | p99 %.3f | max %.3f ms | %.1f FPS\n",
+               label, sorted.size(), total * 1000.0 / sorted.size(), pct(0.50), pct(0.95), pct(0.99),
+               sorted.back() * 1000.0, sorted.size() / total);
+    }
+
+private:
+    std::vector<double> samples;
+};
+
+// --- REPLAY SESSION ---
+class ReplaySession {
+public:
+    // Reads --record ARQ, --replay ARQ and --headless; other arguments are
+    // left for the program. Returns false when a replay can't be opened.
+    bool parseArgs(int argc, char** argv) {
+        for (int i = 1; i < argc; ++i) {
+            if (!strcmp(argv[i], "--record") && i + 1 < argc) recordPath = argv[++i];
+            else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+                if (!player.open(argv[++i])) {
+                    fprintf(stderr, "Erro ao abrir a gravacao %s\n", argv[i]);
+                    return false;
+                }
+                isReplay = true;
+            }
+            else if (!strcmp(argv[i], "--headless")) isHeadless = true;
+        }
+        isHeadless = isHeadless && isReplay;
+        return true;
+    }
+
+    // Settles the start state. Live, `seed` and `payload` are the program's
+    // own and get recorded; replaying, they are replaced by the recording's.
+    void start(uint32_t& seed, std::string& payload) {
+        if (isReplay) {
+            seed    = player.seed();
+            payload = player.payload();
+        } else if (!recordPath.empty() && !recorder.open(recordPath, seed, payload)) {
+            fprintf(stderr, "Erro ao criar %s\n", recordPath.c_str());
+        }
+    }
+
+    void push(const InputEvent& event) {
+        if (!isReplay) queue.push(event);
+    }
+
+    // Calls apply(event) for every event of the tick numbered `tick`, which
+    // ends at `tickTime` on the clock push() timestamps use.
+    template <class Apply>
+    void consume(uint64_t tick, double tickTime, Apply&& apply) {
+        InputEvent event;
+        lastTick = tick;
+        if (isReplay) {
+            while (player.next(tick, event)) apply(event);
+            return;
+        }
+        while (queue.popUntil(tickTime, event)) {
+            recorder.record(tick, event);
+            apply(event);
+        }
+    }
+
+    // Wall-clock frame time live; exactly one tick when replaying, so the
+    // same frames are simulated and drawn on every run.
+    double frameDelta(double wallDelta, double tickStep) const { return isReplay ? tickStep : wallDelta; }
+
+    // Call once per presented frame. The first frame only starts the
+    // clock: measured from start() it would include whatever loading the
+    // program does before its loop.
+    void endFrame() {
+        Clock::time_point now = Clock::now();
+        if (isReplay && framesEnded > 0) stats.add(std::chrono::duration<double>(now - lastFrame).count());
+        lastFrame = now;
+        ++framesEnded;
+    }
+
+    // True once a replay has played its last recorded tick.
+    bool done() const { return isReplay && player.finished(); }
+
+    // Closes the recording, or prints the replay's frame statistics.
+    void finish(const char* label) {
+        if (recorder.isOpen()) recorder.finish(lastTick);
+        if (isReplay) stats.print(label);
+    }
+
+    bool replaying() const { return isReplay; }
+    bool headless() const { return isHeadless; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    InputQueue queue;
+    InputRecorder recorder;
+    InputPlayer player;
+    std::string recordPath;
+    bool isReplay = false, isHeadless = false;
+    uint64_t lastTick = 0;
+    uint64_t framesEnded = 0;
+    Clock::time_point lastFrame;
+    FrameStats stats;
+};
+
+#endif /* Replay_h */
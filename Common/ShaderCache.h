@@ -0,0 +1,223 @@
+//
+//  ShaderCache.h
+//  Builds shader programs and keeps the linked result on disk as a driver
+//  binary (glGetProgramBinary), so later launches load it with
+//  glProgramBinary instead of compiling GLSL again.
+//
+//      GLuint program = shaderCache.build("grauB", vertexSource, fragmentSource);
+//
+//  The cache key is a hash of both sources, after the defines are
+//  inserted, and of the GL vendor, renderer and version strings; a new
+//  driver, a changed shader or a binary the driver refuses all fall back
+//  to compiling, and the fresh binary replaces the old one. Binaries live
+//  in shadercache/<name>.bin in the working directory (the build folder);
+//  deleting it forces a cold compile. Each build prints one line with the
+//  time taken and, on a hit, the compile time it saved.
+//
+//  Shaders kept in files come in through shaderLoader (ShaderSource.h),
+//  whose line map turns driver log positions back into file:line.
+//
+//  Program state that isn't part of the binary (uniform values, uniform
+//  block bindings) is set by the caller after build(), as before. Without
+//  GL 4.1 / ARB_get_program_binary the cache just compiles.
+//
+
+#ifndef ShaderCache_h
+#define ShaderCache_h
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Hash.h"
+#include "ShaderSource.h"
+
+class ShaderCache {
+public:
+    explicit ShaderCache(const std::string& directory = "shadercache") : directory(directory) {}
+
+    // Each define is "NAME" or "NAME VALUE" and becomes a #define line
+    // right after #version. Returns 0 if the program doesn't compile or
+    // link (the log goes to stderr).
+    GLuint build(const std::string& name, const char* vertexSource, const char* fragmentSource,
+                 const std::vector<std::string>& defines = {}) {
+        return buildSources(name, withDefines(vertexSource, defines), withDefines(fragmentSource, defines),
+                            nullptr, nullptr);
+    }
+
+    // Sources from shaderLoader; compile errors name the file and line.
+    GLuint build(const std::string& name, const ShaderSource& vertex, const ShaderSource& fragment) {
+        return buildSources(name, vertex.text, fragment.text, &vertex, &fragment);
+    }
+
+    // Compile time avoided by cache hits so far, net of the time to load them.
+    double totalSavedMs() const { return savedMs; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    static double elapsedMs(Clock::time_point begin) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    }
+
+    GLuint buildSources(const std::string& name, const std::string& vertex, const std::string& fragment,
+                        const ShaderSource* vertexLines, const ShaderSource* fragmentLines) {
+        Clock::time_point begin = Clock::now();
+        uint64_t key = programKey(vertex, fragment);
+        std::string path = directory + "/" + name + ".bin";
+        double compileMs = 0.0;
+        if (supported()) {
+            GLuint program = loadBinary(path, key, compileMs);
+            if (program) {
+                double ms = elapsedMs(begin);
+                savedMs += compileMs - ms;
+                printf("shader %s: binario em cache, %.2f ms (compilar levava %.2f ms, %.2f ms economizados)\n",
+                       name.c_str(), ms, compileMs, compileMs - ms);
+                return program;
+            }
+        }
+        GLuint program = compile(name, vertex, fragment, vertexLines, fragmentLines);
+        compileMs = elapsedMs(begin);
+        if (!program) return 0;
+        bool saved = supported() && saveBinary(path, key, program, compileMs);
+        printf("shader %s: compilado, %.2f ms%s\n", name.c_str(), compileMs, saved ? " (binario salvo)" : "");
+        return program;
+    }
+
+    static bool supported() {
+        if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary) return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    static std::string withDefines(const char* source, const std::vector<std::string>& defines) {
+        std::string text(source);
+        if (defines.empty()) return text;
+        std::string lines;
+        for (const std::string& define : defines) lines += "#define " + define + "\n";
+        // after the #version line, which must come first
+        size_t version = text.find("#version");
+        if (version == std::string::npos) return lines + text;
+        size_t end = text.find('\n', version);
+        if (end == std::string::npos) return text + "\n" + lines;
+        text.insert(end + 1, lines);
+        return text;
+    }
+
+    static uint64_t programKey(const std::string& vertex, const std::string& fragment) {
+        uint64_t key = fnv1a64(&FILE_VERSION, sizeof(FILE_VERSION));
+        key = fnv1a64(vertex.c_str(), vertex.size() + 1, key);
+        key = fnv1a64(fragment.c_str(), fragment.size() + 1, key);
+        const GLenum driver[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum e : driver) {
+            const char* text = (const char*)glGetString(e);
+            if (text) key = fnv1a64(text, strlen(text) + 1, key);
+        }
+        return key;
+    }
+
+    static GLuint compileStage(const std::string& name, GLenum type, const std::string& source,
+                               const ShaderSource* lines) {
+        GLuint shader = glCreateShader(type);
+        const char* text = source.c_str();
+        glShaderSource(shader, 1, &text, nullptr);
+        glCompileShader(shader);
+        GLint success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            GLchar infoLog[1024];
+            glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+            std::cerr << "Erro ao compilar o shader de " << (type == GL_VERTEX_SHADER ? "vertices" : "fragmentos")
+                      << " de " << name << ": " << (lines ? lines->translateLog(infoLog) : std::string(infoLog))
+                      << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static GLuint compile(const std::string& name, const std::string& vertex, const std::string& fragment,
+                          const ShaderSource* vertexLines, const ShaderSource* fragmentLines) {
+        GLuint vertexShader = compileStage(name, GL_VERTEX_SHADER, vertex, vertexLines);
+        GLuint fragmentShader = compileStage(name, GL_FRAGMENT_SHADER, fragment, fragmentLines);
+        if (!vertexShader || !fragmentShader) {
+            glDeleteShader(vertexShader);
+            glDeleteShader(fragmentShader);
+            return 0;
+        }
+        GLuint program = glCreateProgram();
+        if (supported()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+            std::cerr << "Erro ao linkar o programa " << name << ": " << infoLog << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // File: "SHBN", uint32 file version, binary format, binary size,
+    // compile time in microseconds, uint64 key, then the binary.
+    static GLuint loadBinary(const std::string& path, uint64_t key, double& compileMs) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[4];
+        uint32_t header[4];
+        uint64_t storedKey;
+        if (!file.read(magic, 4) || memcmp(magic, "SHBN", 4) != 0) return 0;
+        if (!file.read((char*)header, sizeof(header)) || !file.read((char*)&storedKey, sizeof(storedKey))) return 0;
+        if (header[0] != FILE_VERSION || storedKey != key) return 0;
+        std::vector<char> binary(header[2]);
+        if (!file.read(binary.data(), binary.size())) return 0;
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header[1], binary.data(), (GLsizei)binary.size());
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        compileMs = header[3] / 1000.0;
+        return program;
+    }
+
+    bool saveBinary(const std::string& path, uint64_t key, GLuint program, double compileMs) const {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) return false;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::ofstream file(path, std::ios::binary);
+        uint32_t header[4] = { FILE_VERSION, format, (uint32_t)length, (uint32_t)(compileMs * 1000.0) };
+        file.write("SHBN", 4);
+        file.write((const char*)header, sizeof(header));
+        file.write((const char*)&key, sizeof(key));
+        file.write(binary.data(), length);
+        return (bool)file;
+    }
+
+    std::string directory;
+    double savedMs = 0.0;
+};
+
+// Shared by the whole program, like glState.
+inline ShaderCache shaderCache;
+
+#endif /* ShaderCache_h */
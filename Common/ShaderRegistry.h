@@ -0,0 +1,453 @@
+//
+//  ShaderRegistry.h
+//  Shader programs built from .glsl files that are rebuilt when the files
+//  change, so shaders can be tuned while the program runs.
+//
+//      ShaderRegistry shaders;
+//      int geral = shaders.add("geral", "_geral_vs.glsl", "_geral_fs.glsl");
+//      while (...) {
+//          shaders.poll();                       // once per frame
+//          glUseProgram(shaders.program(geral));
+//
+//  Files are loaded through shaderLoader (ShaderSource.h), so #include
+//  and defines work and logs name the file and line; an edit to an
+//  included file rebuilds every program that includes it.
+//
+//  add() builds the first version right away through shaderCache, so a
+//  program that fails to compile starts with program() == 0 instead of
+//  quitting; fix the file and it appears. poll() notices saved files
+//  (inotify on Linux, modification times elsewhere), starts the rebuild
+//  and returns; with KHR/ARB_parallel_shader_compile the driver compiles
+//  on its own threads and later polls only ask whether it has finished.
+//  Without either extension, startWorker(window) compiles and links on a
+//  thread of its own, in a hidden window sharing the program's context;
+//  if it isn't called, reading the result on the next frame waits for
+//  the compile. The new program replaces the old one, on the GL thread,
+//  only if it links; otherwise the log goes to stderr and the old one
+//  keeps drawing.
+//
+//  program() can change after any poll(), so read it every frame, and
+//  set uniforms that aren't updated per frame (sampler units, ...) in the
+//  onLink() callback. Call destroy() before glfwTerminate() when the
+//  worker runs. Programs are not deleted by the destructor, which may run
+//  after the context is gone.
+//
+
+#ifndef ShaderRegistry_h
+#define ShaderRegistry_h
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ShaderCache.h"
+#include "ShaderSource.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+class ShaderRegistry {
+public:
+    ShaderRegistry() = default;
+    ShaderRegistry(const ShaderRegistry&) = delete;
+    ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+    ~ShaderRegistry() {
+        stopWorker();
+#ifdef __linux__
+        if (notifyFd >= 0) close(notifyFd);
+#endif
+    }
+
+    // Without a parallel-compile extension, rebuilds run on a worker thread
+    // with a hidden window sharing `window`'s context. Call on the main
+    // thread after the window is created; the window hints in effect are
+    // the ones the hidden window gets, as for the program's own window.
+    void startWorker(GLFWwindow* window) {
+        if (entries.empty() && !ready) setUp();
+        if (parallel || workerWindow) return;
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        workerWindow = glfwCreateWindow(1, 1, "shaders", nullptr, window);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (!workerWindow) {
+            std::cerr << "Sem contexto compartilhado; shaders recompilados no quadro seguinte" << std::endl;
+            return;
+        }
+        stopping = false;
+        worker = std::thread([this] { work(); });
+    }
+
+    // Stops the worker and closes its window; the registry keeps working
+    // without it.
+    void destroy() {
+        stopWorker();
+        if (workerWindow) glfwDestroyWindow(workerWindow);
+        workerWindow = nullptr;
+    }
+
+    // Returns the id for program() and onLink(). Defines are passed to
+    // shaderLoader for both stages.
+    int add(const std::string& name, const std::string& vertexPath, const std::string& fragmentPath,
+            const std::vector<std::string>& defines = {}) {
+        if (entries.empty() && !ready) setUp();
+        Entry entry;
+        entry.name = name;
+        entry.paths[0] = vertexPath;
+        entry.paths[1] = fragmentPath;
+        entry.defines = defines;
+        ShaderSource sources[2];
+        bool loaded = loadSources(entry, sources);
+        if (loaded) entry.current = shaderCache.build(name, sources[0], sources[1]);
+        entries.push_back(entry);
+        return (int)entries.size() - 1;
+    }
+
+    // 0 until a version of the program has linked.
+    GLuint program(int id) const { return entries[id].current; }
+
+    // Runs now if the program is already linked, and after every reload.
+    void onLink(int id, std::function<void(GLuint)> callback) {
+        entries[id].linked = callback;
+        if (entries[id].current && callback) callback(entries[id].current);
+    }
+
+    void poll() {
+        detectChanges();
+        for (Entry& entry : entries)
+            if (entry.pending || entry.queued) ++entry.framesWaited;
+        collectBuilt();
+        for (Entry& entry : entries) {
+            if (entry.pending && finished(entry)) finish(entry);
+            if (entry.changed && !entry.pending && !entry.queued) {
+                entry.changed = false;
+                start(entry);
+            }
+        }
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    // how often file times are compared when inotify isn't available
+    static constexpr double SCAN_INTERVAL_SECONDS = 0.25;
+
+    struct File {
+        std::string path;
+        std::filesystem::file_time_type written;
+    };
+
+    struct Entry {
+        std::string name;
+        std::string paths[2];           // vertex, fragment
+        std::vector<std::string> defines;
+        std::vector<File> files;        // both stages and what they include
+        GLuint current = 0;
+        GLuint pending = 0;             // being compiled, not yet checked
+        GLuint pendingShaders[2] = { 0, 0 };
+        ShaderSource pendingSources[2]; // for the line numbers in the log
+        bool queued = false;            // handed to the worker
+        bool changed = false;           // saved again since the last start()
+        int framesWaited = 0;
+        Clock::time_point started;
+        std::function<void(GLuint)> linked;
+    };
+
+    // Compiled and linked by the worker, checked there so that reading the
+    // status on the GL thread doesn't wait.
+    struct Built {
+        size_t entry;
+        GLuint program;
+        bool linked;
+        std::string log;
+    };
+
+    struct Job {
+        size_t entry;
+        std::string name, paths[2];
+        ShaderSource sources[2];
+    };
+
+    void setUp() {
+        ready = true;
+        if (GLAD_GL_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);   // as many as the driver likes
+            parallel = true;
+        } else if (GLAD_GL_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            parallel = true;
+        }
+#ifdef __linux__
+        notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    }
+
+    static std::filesystem::file_time_type writeTime(const std::string& path) {
+        std::error_code error;
+        return std::filesystem::last_write_time(path, error);
+    }
+
+    static std::string directoryOf(const std::string& path) {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? "." : path.substr(0, slash);
+    }
+
+    static std::string fileNameOf(const std::string& path) {
+        return path.substr(path.find_last_of('/') + 1);
+    }
+
+    // Directories are watched rather than files: editors often save by
+    // writing a new file and renaming it over the old one.
+    void watch(const std::string& path) {
+#ifdef __linux__
+        if (notifyFd < 0) return;
+        std::string directory = directoryOf(path);
+        for (const auto& w : watches)
+            if (w.second == directory) return;
+        int wd = inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd >= 0) watches.emplace_back(wd, directory);
+#else
+        (void)path;
+#endif
+    }
+
+    void markChanged(const std::string& directory, const std::string& fileName) {
+        for (Entry& entry : entries) {
+            for (File& file : entry.files) {
+                if (fileNameOf(file.path) != fileName || directoryOf(file.path) != directory) continue;
+                shaderLoader.forget(file.path);
+                entry.changed = true;
+            }
+        }
+    }
+
+    void detectChanges() {
+#ifdef __linux__
+        if (notifyFd >= 0) {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(notifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* at = buffer; at < buffer + length;) {
+                    const inotify_event* event = (const inotify_event*)at;
+                    at += sizeof(inotify_event) + event->len;
+                    if (event->len == 0) continue;
+                    for (const auto& w : watches)
+                        if (w.first == event->wd) markChanged(w.second, event->name);
+                }
+            }
+            return;
+        }
+#endif
+        Clock::time_point now = Clock::now();
+        if (std::chrono::duration<double>(now - lastScan).count() < SCAN_INTERVAL_SECONDS) return;
+        lastScan = now;
+        for (Entry& entry : entries) {
+            for (File& file : entry.files) {
+                std::filesystem::file_time_type written = writeTime(file.path);
+                if (written != file.written) {
+                    file.written = written;
+                    shaderLoader.forget(file.path);
+                    entry.changed = true;
+                }
+            }
+        }
+    }
+
+    // Also refreshes the list of files to watch, which changes when an
+    // #include is added or removed. Files that failed to load stay in it.
+    bool loadSources(Entry& entry, ShaderSource sources[2]) {
+        bool loaded = true;
+        std::vector<std::string> paths;
+        for (int i = 0; i < 2; ++i) {
+            if (!shaderLoader.load(entry.paths[i], sources[i], entry.defines)) {
+                std::cerr << sources[i].error << std::endl;
+                loaded = false;
+                paths.push_back(ShaderLoader::normalize(entry.paths[i]));
+            }
+            paths.insert(paths.end(), sources[i].files.begin(), sources[i].files.end());
+        }
+        if (!loaded)
+            for (const File& file : entry.files) paths.push_back(file.path);
+        std::vector<File> files;
+        for (const std::string& path : paths) {
+            bool known = false;
+            for (const File& file : files) known = known || file.path == path;
+            if (known) continue;
+            files.push_back(File{ path, writeTime(path) });
+            watch(path);
+        }
+        entry.files = files;
+        return loaded;
+    }
+
+    // Queues compile and link without asking for any result, which is
+    // what would wait for the driver; or hands the sources to the worker.
+    void start(Entry& entry) {
+        if (!loadSources(entry, entry.pendingSources)) return;
+        entry.framesWaited = 0;
+        entry.started = Clock::now();
+        if (worker.joinable()) {
+            Job job;
+            job.entry = &entry - entries.data();
+            job.name = entry.name;
+            job.paths[0] = entry.paths[0];
+            job.paths[1] = entry.paths[1];
+            job.sources[0] = entry.pendingSources[0];
+            job.sources[1] = entry.pendingSources[1];
+            entry.queued = true;
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+            jobReady.notify_one();
+            return;
+        }
+        const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+        entry.pending = glCreateProgram();
+        for (int i = 0; i < 2; ++i) {
+            const char* text = entry.pendingSources[i].text.c_str();
+            entry.pendingShaders[i] = glCreateShader(types[i]);
+            glShaderSource(entry.pendingShaders[i], 1, &text, nullptr);
+            glCompileShader(entry.pendingShaders[i]);
+            glAttachShader(entry.pending, entry.pendingShaders[i]);
+        }
+        glLinkProgram(entry.pending);
+    }
+
+    bool finished(const Entry& entry) const {
+        if (!parallel) return true;   // finish() then waits for the driver
+        GLint done = GL_FALSE;
+        glGetProgramiv(entry.pending, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+
+    void finish(Entry& entry) {
+        GLint success;
+        glGetProgramiv(entry.pending, GL_LINK_STATUS, &success);
+        std::string log = success ? std::string() : errorLog(entry.name, entry.paths, entry.pendingShaders,
+                                                             entry.pendingSources, entry.pending);
+        for (GLuint& shader : entry.pendingShaders) {
+            glDeleteShader(shader);
+            shader = 0;
+        }
+        swap(entry, entry.pending, success == GL_TRUE, log);
+        entry.pending = 0;
+    }
+
+    // On the GL thread, for either path.
+    void swap(Entry& entry, GLuint program, bool linked, const std::string& log) {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - entry.started).count();
+        if (linked) {
+            if (entry.current) glDeleteProgram(entry.current);
+            entry.current = program;
+            printf("shader %s: recarregado em %.2f ms (%d quadros)\n", entry.name.c_str(), ms, entry.framesWaited);
+            if (entry.linked) entry.linked(entry.current);
+        } else {
+            std::cerr << log << "shader " << entry.name << ": mantida a versao anterior" << std::endl;
+            glDeleteProgram(program);
+        }
+    }
+
+    static std::string errorLog(const std::string& name, const std::string paths[2], const GLuint shaders[2],
+                                const ShaderSource sources[2], GLuint program) {
+        GLchar infoLog[1024];
+        std::string log;
+        for (int i = 0; i < 2; ++i) {
+            GLint compiled;
+            glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+            if (compiled) continue;
+            glGetShaderInfoLog(shaders[i], sizeof(infoLog), nullptr, infoLog);
+            log += "Erro ao compilar " + paths[i] + ": " + sources[i].translateLog(infoLog) + "\n";
+        }
+        if (log.empty()) {
+            glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
+            log = "Erro ao linkar o programa " + name + ": " + infoLog + "\n";
+        }
+        return log;
+    }
+
+    // --- WORKER ---
+    // Entries are only touched on the GL thread; the worker sees copies of
+    // the sources and hands back a program that has finished linking.
+    void work() {
+        glfwMakeContextCurrent(workerWindow);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) break;
+            Job job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+            GLuint shaders[2];
+            GLuint program = glCreateProgram();
+            for (int i = 0; i < 2; ++i) {
+                const char* text = job.sources[i].text.c_str();
+                shaders[i] = glCreateShader(types[i]);
+                glShaderSource(shaders[i], 1, &text, nullptr);
+                glCompileShader(shaders[i]);
+                glAttachShader(program, shaders[i]);
+            }
+            glLinkProgram(program);
+            GLint success;
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+            Built built{ job.entry, program, success == GL_TRUE, std::string() };
+            if (!built.linked) built.log = errorLog(job.name, job.paths, shaders, job.sources, program);
+            for (GLuint shader : shaders) glDeleteShader(shader);
+            glFinish();   // the program is complete before the GL thread uses it
+            lock.lock();
+            builtPrograms.push_back(std::move(built));
+        }
+        lock.unlock();
+        glfwMakeContextCurrent(nullptr);
+    }
+
+    void collectBuilt() {
+        if (!worker.joinable()) return;
+        std::vector<Built> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(builtPrograms);
+        }
+        for (Built& built : done) {
+            Entry& entry = entries[built.entry];
+            entry.queued = false;
+            swap(entry, built.program, built.linked, built.log);
+        }
+    }
+
+    void stopWorker() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            jobReady.notify_one();
+        }
+        worker.join();
+    }
+
+    std::vector<Entry> entries;
+    bool parallel = false, ready = false;
+    Clock::time_point lastScan;
+#ifdef __linux__
+    int notifyFd = -1;
+    std::vector<std::pair<int, std::string>> watches;   // descriptor, directory
+#endif
+    // shared with the worker
+    GLFWwindow* workerWindow = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    std::vector<Built> builtPrograms;
+    bool stopping = false;
+};
+
+#endif /* ShaderRegistry_h */
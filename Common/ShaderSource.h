@@ -0,0 +1,238 @@
+//
+//  ShaderSource.h
+//  GLSL loaded from files. Each file is read whole, once per run, and
+//  kept; #include "file" lines are replaced by that file (the path is
+//  relative to the including file); #defines for a permutation go right
+//  after #version; and every line of the result remembers which file and
+//  line it came from, so compile logs can point at the real source.
+//  No GL here; ShaderCache::build takes the result.
+//
+//      ShaderSource vertex, fragment;
+//      if (!shaderLoader.load("sprite_vs.glsl", vertex, { "CUTOUT", "LIGHTS 4" }))
+//          std::cerr << vertex.error;
+//
+//  A file is included at most once per shader, like #pragma once, which
+//  also makes include cycles harmless; #version lines inside included
+//  files are dropped. Splitting a file into lines and finding its
+//  directives is done when it is first read, so a large library included
+//  by many shaders costs one parse, and assembling a shader is linear in
+//  its length. Not thread safe.
+//
+
+#ifndef ShaderSource_h
+#define ShaderSource_h
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct ShaderLineOrigin {
+    uint32_t file;   // index into ShaderSource::files, or DEFINES
+    uint32_t line;   // 1-based
+    static constexpr uint32_t DEFINES = 0xFFFFFFFF;
+};
+
+struct ShaderSource {
+    std::string text;
+    std::vector<std::string> files;          // files[0] is the one loaded
+    std::vector<ShaderLineOrigin> lines;     // one per line of text
+    std::string error;                       // set when load() fails
+
+    // "file:line" for a 1-based line of text.
+    std::string location(size_t line) const {
+        if (line == 0 || line > lines.size()) return "?:" + std::to_string(line);
+        const ShaderLineOrigin& origin = lines[line - 1];
+        if (origin.file == ShaderLineOrigin::DEFINES) return "#define";
+        return files[origin.file] + ":" + std::to_string(origin.line);
+    }
+
+    // Rewrites the line references at the start of each log line, in the
+    // forms drivers use ("0(12)", "0:12(5):", "ERROR: 0:12:"), as file:line.
+    std::string translateLog(const std::string& log) const {
+        std::string out;
+        out.reserve(log.size());
+        size_t begin = 0;
+        while (begin < log.size()) {
+            size_t end = log.find('\n', begin);
+            end = end == std::string::npos ? log.size() : end + 1;
+            out += translateLogLine(log.substr(begin, end - begin));
+            begin = end;
+        }
+        return out;
+    }
+
+private:
+    static size_t digitsAt(const std::string& s, size_t at) {
+        size_t end = at;
+        while (end < s.size() && s[end] >= '0' && s[end] <= '9') ++end;
+        return end - at;
+    }
+
+    std::string translateLogLine(const std::string& line) const {
+        size_t at = 0;
+        for (const char* prefix : { "ERROR: ", "WARNING: " }) {
+            if (line.compare(0, strlen(prefix), prefix) == 0) at = strlen(prefix);
+        }
+        size_t stringDigits = digitsAt(line, at);
+        size_t separator = at + stringDigits;
+        if (stringDigits == 0 || separator >= line.size() || (line[separator] != ':' && line[separator] != '(')) return line;
+        size_t lineDigits = digitsAt(line, separator + 1);
+        if (lineDigits == 0) return line;
+        size_t end = separator + 1 + lineDigits;
+        if (line[separator] == '(') {
+            if (end >= line.size() || line[end] != ')') return line;
+            ++end;
+        }
+        size_t number = std::stoul(line.substr(separator + 1, lineDigits));
+        return line.substr(0, at) + location(number) + line.substr(end);
+    }
+};
+
+class ShaderLoader {
+public:
+    // Each define is "NAME" or "NAME VALUE". On failure source.error says
+    // which file couldn't be read or which #include is malformed.
+    bool load(const std::string& path, ShaderSource& source, const std::vector<std::string>& defines = {}) {
+        source = ShaderSource();
+        std::unordered_set<std::string> included;
+        std::string root = normalize(path);
+        const File* file = read(root);
+        if (!file) {
+            source.error = "Erro ao abrir o shader " + root;
+            return false;
+        }
+        source.text.reserve(file->text.size());
+        source.lines.reserve(file->lineStarts.size());
+        if (file->version < 0) appendDefines(source, defines);
+        return append(root, *file, source, included, &defines);
+    }
+
+    // Drops a file so the next load() reads it from disk again.
+    void forget(const std::string& path) { files.erase(normalize(path)); }
+    void clear() { files.clear(); }
+
+    static std::string normalize(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+private:
+    struct Include {
+        uint32_t line;          // 0-based line of the directive
+        std::string target;     // normalized path; empty if malformed
+    };
+
+    struct File {
+        std::string text;                   // always ends with '\n'
+        std::vector<size_t> lineStarts;
+        std::vector<Include> includes;      // in line order
+        int version = -1;                   // 0-based line of #version
+    };
+
+    // Returns the directive word of a preprocessor line and where its
+    // argument starts, or an empty string.
+    static std::string directive(const std::string& text, size_t begin, size_t end, size_t& argument) {
+        size_t at = text.find_first_not_of(" \t", begin);
+        if (at >= end || text[at] != '#') return std::string();
+        at = text.find_first_not_of(" \t", at + 1);
+        size_t wordEnd = at;
+        while (wordEnd < end && isalpha((unsigned char)text[wordEnd])) ++wordEnd;
+        argument = wordEnd;
+        return text.substr(at, wordEnd - at);
+    }
+
+    const File* read(const std::string& path) {
+        auto cached = files.find(path);
+        if (cached != files.end()) return &cached->second;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return nullptr;
+        File file;
+        file.text.resize((size_t)in.tellg());
+        in.seekg(0);
+        if (!in.read(&file.text[0], file.text.size())) return nullptr;
+        if (file.text.empty() || file.text.back() != '\n') file.text += '\n';
+        std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (size_t begin = 0; begin < file.text.size();) {
+            size_t end = file.text.find('\n', begin) + 1;
+            uint32_t line = (uint32_t)file.lineStarts.size();
+            file.lineStarts.push_back(begin);
+            size_t argument = 0;
+            std::string word = directive(file.text, begin, end, argument);
+            if (word == "version" && file.version < 0) {
+                file.version = (int)line;
+            } else if (word == "include") {
+                Include include{ line, std::string() };
+                size_t open = file.text.find_first_of("\"<", argument);
+                if (open < end) {
+                    size_t close = file.text.find(file.text[open] == '"' ? '"' : '>', open + 1);
+                    if (close < end)
+                        include.target = normalize((directory / file.text.substr(open + 1, close - open - 1)).generic_string());
+                }
+                file.includes.push_back(include);
+            }
+            begin = end;
+        }
+        file.lineStarts.push_back(file.text.size());
+        return &files.emplace(path, std::move(file)).first->second;
+    }
+
+    static void appendDefines(ShaderSource& source, const std::vector<std::string>& defines) {
+        for (const std::string& define : defines) {
+            source.text += "#define " + define + "\n";
+            source.lines.push_back(ShaderLineOrigin{ ShaderLineOrigin::DEFINES, 0 });
+        }
+    }
+
+    // Copies lines [from, to) of a file.
+    static void appendLines(const File& file, uint32_t index, uint32_t from, uint32_t to, ShaderSource& source) {
+        if (from >= to) return;
+        source.text.append(file.text, file.lineStarts[from], file.lineStarts[to] - file.lineStarts[from]);
+        for (uint32_t line = from; line < to; ++line) source.lines.push_back(ShaderLineOrigin{ index, line + 1 });
+    }
+
+    // defines is null for included files, whose #version is dropped.
+    bool append(const std::string& path, const File& file, ShaderSource& source,
+                std::unordered_set<std::string>& included, const std::vector<std::string>* defines) {
+        included.insert(path);
+        uint32_t index = (uint32_t)source.files.size();
+        source.files.push_back(path);
+        uint32_t lineCount = (uint32_t)file.lineStarts.size() - 1;
+        uint32_t next = 0;
+        if (file.version >= 0) {
+            appendLines(file, index, 0, defines ? file.version + 1 : file.version, source);
+            if (defines) appendDefines(source, *defines);
+            next = file.version + 1;
+        }
+        for (const Include& include : file.includes) {
+            if (include.line < next) continue;
+            appendLines(file, index, next, include.line, source);
+            next = include.line + 1;
+            std::string where = path + ":" + std::to_string(include.line + 1);
+            if (include.target.empty()) {
+                source.error = "#include malformado em " + where;
+                return false;
+            }
+            if (included.count(include.target)) continue;
+            const File* child = read(include.target);
+            if (!child) {
+                source.error = "Erro ao abrir " + include.target + " (incluido em " + where + ")";
+                return false;
+            }
+            if (!append(include.target, *child, source, included, nullptr)) return false;
+        }
+        appendLines(file, index, next, lineCount, source);
+        return true;
+    }
+
+    std::unordered_map<std::string, File> files;
+};
+
+// Shared by the whole program, like shaderCache.
+inline ShaderLoader shaderLoader;
+
+#endif /* ShaderSource_h */
@@ -0,0 +1,65 @@
+//
+//  SparseSet.h
+//  Set of small integer keys (tile or cell indices) with O(1) insert,
+//  erase, lookup and clear, and iteration over the members only. Used to
+//  index pickups and live entities so that counting, drawing and queries
+//  cost O(entities) instead of O(map size).
+//
+//  erase() moves the last member into the hole, so when erasing while
+//  iterating, walk the members backwards.
+//
+
+#ifndef SparseSet_h
+#define SparseSet_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SparseSet {
+public:
+    // Keys must be below `capacity`; existing members are dropped.
+    void init(uint32_t capacity) {
+        sparse.assign(capacity, 0);
+        dense.clear();
+    }
+
+    bool contains(uint32_t key) const {
+        if (key >= sparse.size()) return false;
+        uint32_t slot = sparse[key];
+        return slot < dense.size() && dense[slot] == key;
+    }
+
+    bool insert(uint32_t key) {
+        if (key >= sparse.size() || contains(key)) return false;
+        sparse[key] = (uint32_t)dense.size();
+        dense.push_back(key);
+        return true;
+    }
+
+    bool erase(uint32_t key) {
+        if (!contains(key)) return false;
+        uint32_t slot = sparse[key];
+        uint32_t last = dense.back();
+        dense[slot]  = last;
+        sparse[last] = slot;
+        dense.pop_back();
+        return true;
+    }
+
+    void clear() { dense.clear(); }
+
+    size_t size() const { return dense.size(); }
+    bool empty() const { return dense.empty(); }
+    uint32_t capacity() const { return (uint32_t)sparse.size(); }
+    uint32_t operator[](size_t i) const { return dense[i]; }
+
+    std::vector<uint32_t>::const_iterator begin() const { return dense.begin(); }
+    std::vector<uint32_t>::const_iterator end() const { return dense.end(); }
+
+private:
+    std::vector<uint32_t> sparse;   // key -> slot in dense (stale entries are harmless)
+    std::vector<uint32_t> dense;    // members in insertion order, minus erasures
+};
+
+#endif /* SparseSet_h */
@@ -0,0 +1,182 @@
+//
+//  SpriteBatch.h
+//  Immediate-mode sprite batcher. Quads are expanded straight into a
+//  triple-buffered streaming vertex buffer (persistently mapped with fences
+//  on GL 4.4, orphaned on GL 3.3) and drawn with one glDrawElements per run
+//  of sprites that share program, texture and blend mode. The batch
+//  flushes when that state changes or when it reaches its capacity.
+//
+
+#ifndef SpriteBatch_h
+#define SpriteBatch_h
+
+#include <glad/glad.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "GLStateCache.h"
+#include "StreamBuffer.h"
+
+enum BlendMode { BLEND_OPAQUE, BLEND_ALPHA, BLEND_PREMULTIPLIED, BLEND_ADDITIVE };
+
+// Rectangle with its texture rectangle; (u0, v0) maps to (x, y) and
+// (u1, v1) to (x + w, y + h). Rotation is in radians around the centre.
+// A diamond keeps only the rhombus through the midpoints of the edges,
+// with the same texture mapping, which is the shape of an isometric tile;
+// it ignores rotation.
+struct SpriteQuad {
+    float x, y, w, h;
+    float u0, v0, u1, v1;
+    uint32_t color;   // RGBA8, multiplied with the texture
+    float rotation = 0.0f;
+    bool diamond = false;
+};
+
+inline uint32_t packColor(float r, float g, float b, float a = 1.0f) {
+    return (uint32_t)(r * 255.0f + 0.5f) | (uint32_t)(g * 255.0f + 0.5f) << 8 |
+           (uint32_t)(b * 255.0f + 0.5f) << 16 | (uint32_t)(a * 255.0f + 0.5f) << 24;
+}
+
+const uint32_t COLOR_WHITE = 0xFFFFFFFFu;
+
+struct BatchStats {
+    unsigned sprites = 0;
+    unsigned draws   = 0;
+};
+
+inline void applyBlendMode(BlendMode blend) {
+    switch (blend) {
+        case BLEND_OPAQUE:        glState.setBlend(false); break;
+        case BLEND_ALPHA:         glState.setBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); break;
+        case BLEND_PREMULTIPLIED: glState.setBlend(true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA); break;
+        case BLEND_ADDITIVE:      glState.setBlend(true, GL_SRC_ALPHA, GL_ONE); break;
+    }
+}
+
+class SpriteBatch {
+public:
+    // Vertex layout expected by programs drawn through the batch:
+    //   location 0 vec2 position, location 1 vec2 texcoord, location 2 vec4 color
+    struct Vertex { float x, y, u, v; uint32_t color; };
+
+    // `capacity` is the largest number of sprites in one draw; each of the
+    // three stream segments holds `spritesPerFrame` sprites.
+    void init(int capacity = 16384, int spritesPerFrame = 131072) {
+        this->capacity = capacity;
+        stream.init(GL_ARRAY_BUFFER, (GLsizeiptr)spritesPerFrame * 4 * sizeof(Vertex));
+        glGenVertexArrays(1, &vao);
+        glState.bindVertexArray(vao);
+        glState.bindBuffer(GL_ARRAY_BUFFER, stream.id());
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)(4 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        std::vector<GLuint> indices(capacity * 6);
+        for (int i = 0; i < capacity; ++i) {
+            GLuint v = i * 4;
+            GLuint quad[6] = { v, v + 1, v + 2, v, v + 2, v + 3 };
+            for (int k = 0; k < 6; ++k) indices[i * 6 + k] = quad[k];
+        }
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);   // recorded in the VAO
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    }
+
+    void beginFrame() { stream.beginFrame(); }
+
+    void endFrame() {
+        flush();
+        stream.endFrame();
+    }
+
+    void draw(GLuint program, GLuint texture, BlendMode blend, const SpriteQuad& q) {
+        if (count > 0 && (program != curProgram || texture != curTexture || blend != curBlend)) flush();
+        if (count == 0) open(program, texture, blend);
+        Vertex* v = cursor;
+        float x1 = q.x + q.w, y1 = q.y + q.h;
+        if (q.diamond) {
+            float cx = q.x + q.w * 0.5f, cy = q.y + q.h * 0.5f;
+            float cu = (q.u0 + q.u1) * 0.5f, cv = (q.v0 + q.v1) * 0.5f;
+            v[0] = { cx,  q.y, cu,   q.v0, q.color };   // top
+            v[1] = { q.x, cy,  q.u0, cv,   q.color };   // left
+            v[2] = { cx,  y1,  cu,   q.v1, q.color };   // bottom
+            v[3] = { x1,  cy,  q.u1, cv,   q.color };   // right
+        } else if (q.rotation == 0.0f) {
+            v[0] = { q.x, q.y, q.u0, q.v0, q.color };
+            v[1] = { q.x, y1,  q.u0, q.v1, q.color };
+            v[2] = { x1,  y1,  q.u1, q.v1, q.color };
+            v[3] = { x1,  q.y, q.u1, q.v0, q.color };
+        } else {
+            float hw = q.w * 0.5f, hh = q.h * 0.5f;
+            float cx = q.x + hw, cy = q.y + hh;
+            float c = cosf(q.rotation), s = sinf(q.rotation);
+            float ax = c * hw, ay = s * hw;    // rotated half-width axis
+            float bx = -s * hh, by = c * hh;   // rotated half-height axis
+            v[0] = { cx - ax - bx, cy - ay - by, q.u0, q.v0, q.color };
+            v[1] = { cx - ax + bx, cy - ay + by, q.u0, q.v1, q.color };
+            v[2] = { cx + ax + bx, cy + ay + by, q.u1, q.v1, q.color };
+            v[3] = { cx + ax - bx, cy + ay - by, q.u1, q.v0, q.color };
+        }
+        cursor += 4;
+        if (++count == windowSprites) flush();
+    }
+
+    // Draws everything accumulated since the last flush.
+    void flush() {
+        if (count == 0) return;
+        stream.unmap((GLsizeiptr)count * 4 * sizeof(Vertex));
+        glState.useProgram(curProgram);
+        glState.bindTexture(0, GL_TEXTURE_2D, curTexture);
+        applyBlendMode(curBlend);
+        glState.bindVertexArray(vao);
+        glDrawElementsBaseVertex(GL_TRIANGLES, count * 6, GL_UNSIGNED_INT, (void*)0, baseVertex);
+        stats.sprites += count;
+        stats.draws++;
+        count = 0;
+    }
+
+    // Returns the counters of the frame that just ended and starts a new one.
+    BatchStats takeStats() {
+        BatchStats frame = stats;
+        stats = BatchStats();
+        return frame;
+    }
+
+    bool isPersistent() const { return stream.isPersistent(); }
+
+    // Call before glfwTerminate; nothing is freed on destruction.
+    void destroy() {
+        stream.release();
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &ebo);
+        vao = ebo = 0;
+        cursor = nullptr;
+    }
+
+private:
+    void open(GLuint program, GLuint texture, BlendMode blend) {
+        GLintptr offset;
+        GLsizeiptr available;
+        GLsizeiptr quadSize = 4 * sizeof(Vertex);
+        cursor = (Vertex*)stream.map(quadSize, (GLsizeiptr)capacity * quadSize, sizeof(Vertex), offset, available);
+        windowSprites = (int)(available / quadSize);
+        baseVertex    = (GLint)(offset / sizeof(Vertex));
+        curProgram    = program;
+        curTexture    = texture;
+        curBlend      = blend;
+    }
+
+    int capacity = 16384;
+    GLuint vao = 0, ebo = 0;
+    StreamBuffer stream;
+    Vertex* cursor = nullptr;
+    int count = 0, windowSprites = 0;
+    GLint baseVertex = 0;
+    GLuint curProgram = 0, curTexture = 0;
+    BlendMode curBlend = BLEND_ALPHA;
+    BatchStats stats;
+};
+
+#endif /* SpriteBatch_h */
@@ -0,0 +1,93 @@
+//
+//  StartupTrace.h
+//  Timestamps the init phases of a program, so cold-start time can be
+//  broken down (GLFW, context, GL loader, shaders, textures, ...) and
+//  compared between builds with tools/startupBench.
+//
+//    prog --startup-trace ARQ      runs in a hidden window, draws one frame,
+//                                  appends one line to ARQ and quits:
+//                                  "prog fase=ms fase=ms ... total=ms"
+//
+//  The program calls phase("name") at the end of each init step; the time
+//  since the previous mark (or since the trace was constructed) is charged
+//  to that name, and repeated names add up. frameDone() after the first
+//  buffer swap closes the trace. Without the flag every call is cheap and
+//  nothing is written. GLFW-free: the program applies headless() to its
+//  window and quits when frameDone() says so.
+//
+//  GL calls are asynchronous: drivers may finish compiling a program or
+//  uploading a texture only when it is first drawn, so part of "shaders"
+//  and "textures" can show up in "firstFrame".
+//
+
+#ifndef StartupTrace_h
+#define StartupTrace_h
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+class StartupTrace {
+public:
+    StartupTrace() : last(Clock::now()) {}
+
+    // Reads --startup-trace ARQ; other arguments are left for the program.
+    void parseArgs(int argc, char** argv) {
+        if (argc > 0) {
+            program = argv[0];
+            program.erase(0, program.find_last_of("/\\") + 1);
+        }
+        for (int i = 1; i < argc; ++i)
+            if (!strcmp(argv[i], "--startup-trace") && i + 1 < argc) path = argv[++i];
+    }
+
+    bool enabled() const { return !path.empty(); }
+    // Traced runs open no visible window and skip vsync waits.
+    bool headless() const { return enabled(); }
+
+    // Ends the current phase.
+    void phase(const char* name) {
+        if (!enabled() || written) return;
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+        for (auto& p : phases) {
+            if (p.first == name) { p.second += ms; return; }
+        }
+        phases.emplace_back(name, ms);
+    }
+
+    // Call after every buffer swap. The first one ends the "firstFrame"
+    // phase and writes the trace; returns true if the program should quit.
+    bool frameDone() {
+        if (!enabled() || written) return false;
+        phase("firstFrame");
+        written = true;
+        FILE* file = fopen(path.c_str(), "a");
+        if (!file) {
+            fprintf(stderr, "Erro ao abrir %s\n", path.c_str());
+            return true;
+        }
+        double total = 0.0;
+        fprintf(file, "%s", program.c_str());
+        for (const auto& p : phases) {
+            fprintf(file, " %s=%.3f", p.first.c_str(), p.second);
+            total += p.second;
+        }
+        fprintf(file, " total=%.3f\n", total);
+        fclose(file);
+        return true;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last;
+    std::vector<std::pair<std::string, double>> phases;
+    std::string path, program = "?";
+    bool written = false;
+};
+
+#endif /* StartupTrace_h */
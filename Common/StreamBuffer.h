@@ -0,0 +1,144 @@
+//
+//  StreamBuffer.h
+//  Ring of per-frame segments for data that is rewritten every frame.
+//
+//  With GL 4.4 / ARB_buffer_storage the whole ring is persistently mapped
+//  and each segment is guarded by a fence, so writes are plain memcpy.
+//  On GL 3.3 the buffer is orphaned when the ring wraps and segments are
+//  filled with glBufferSubData, which never touches a range the GPU may
+//  still be reading, so that path needs no fences.
+//
+//  The buffer is freed by release(), not by a destructor: globals are
+//  destroyed after glfwTerminate, when there is no context to free it in.
+//
+
+#ifndef StreamBuffer_h
+#define StreamBuffer_h
+
+#include <glad/glad.h>
+#include "GLStateCache.h"
+#include <cstring>
+#include <vector>
+
+class StreamBuffer {
+public:
+    void init(GLenum target, GLsizeiptr segmentSize, int segments = 3) {
+        this->target      = target;
+        this->segmentSize = segmentSize;
+        this->segments    = segments;
+        this->segment     = 0;
+        this->cursor      = 0;
+        fences.assign(segments, (GLsync)0);
+        persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+        glGenBuffers(1, &buffer);
+        glState.bindBuffer(target, buffer);
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, segmentSize * segments, nullptr, flags);
+            mapped = (char*)glMapBufferRange(target, 0, segmentSize * segments, flags);
+            if (!mapped) persistent = false;
+        }
+        if (!persistent) glBufferData(target, segmentSize * segments, nullptr, GL_STREAM_DRAW);
+    }
+
+    void release() {
+        for (GLsync& fence : fences) if (fence) { glDeleteSync(fence); fence = 0; }
+        if (buffer) {
+            if (mapped) {
+                glState.bindBuffer(target, buffer);
+                glUnmapBuffer(target);
+                mapped = nullptr;
+            }
+            glState.forgetBuffer(buffer);
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+    }
+
+    // Moves to the next segment: waits until the GPU is done with it when
+    // mapped, orphans the buffer on wrap otherwise.
+    void beginFrame() {
+        segment = (segment + 1) % segments;
+        cursor  = 0;
+        if (persistent) waitSegment(segment);
+        else if (segment == 0) {
+            glState.bindBuffer(target, buffer);
+            glBufferData(target, segmentSize * segments, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    // Fences the segment written this frame; call after its last draw.
+    void endFrame() {
+        if (!persistent) return;
+        if (fences[segment]) glDeleteSync(fences[segment]);
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // Opens a write window of at least `minSize` and at most `maxSize` bytes
+    // at the cursor and returns where to write; `available` receives the
+    // window size and `offset` its position in the buffer. Persistent mode
+    // hands out mapped memory; the fallback stages the bytes until unmap().
+    char* map(GLsizeiptr minSize, GLsizeiptr maxSize, GLsizeiptr alignment, GLintptr& offset, GLsizeiptr& available) {
+        GLsizeiptr start = (cursor + alignment - 1) / alignment * alignment;
+        if (start + minSize > segmentSize) {
+            endFrame();
+            beginFrame();
+            start = 0;
+        }
+        available  = segmentSize - start < maxSize ? segmentSize - start : maxSize;
+        offset     = segment * segmentSize + start;
+        windowBase = offset;
+        cursor     = start;
+        if (persistent) return mapped + offset;
+        if ((GLsizeiptr)staging.size() < segmentSize) staging.resize(segmentSize);
+        return staging.data();
+    }
+
+    // Closes the window opened by map() after `used` bytes were written.
+    void unmap(GLsizeiptr used) {
+        if (!persistent && used > 0) {
+            glState.bindBuffer(target, buffer);
+            glBufferSubData(target, windowBase, used, staging.data());
+        }
+        cursor += used;
+    }
+
+    // Copies `size` bytes into the current segment and returns their offset
+    // in the buffer. A full segment rolls over into the next one.
+    GLintptr write(const void* data, GLsizeiptr size, GLsizeiptr alignment = 1) {
+        GLintptr offset;
+        GLsizeiptr available;
+        char* dst = map(size, size, alignment, offset, available);
+        memcpy(dst, data, size);
+        unmap(size);
+        return offset;
+    }
+
+    GLuint id() const { return buffer; }
+    bool isPersistent() const { return persistent; }
+    GLsizeiptr getSegmentSize() const { return segmentSize; }
+
+private:
+    void waitSegment(int index) {
+        GLsync fence = fences[index];
+        if (!fence) return;
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        while (status == GL_TIMEOUT_EXPIRED) status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        glDeleteSync(fence);
+        fences[index] = 0;
+    }
+
+    GLenum target = GL_ARRAY_BUFFER;
+    GLuint buffer = 0;
+    GLsizeiptr segmentSize = 0;
+    GLsizeiptr cursor = 0;
+    GLintptr windowBase = 0;
+    int segments = 3;
+    int segment = 0;
+    bool persistent = false;
+    char* mapped = nullptr;
+    std::vector<GLsync> fences;
+    std::vector<char> staging;
+};
+
+#endif /* StreamBuffer_h */
@@ -0,0 +1,187 @@
+//
+//  TextureLoader.h
+//  Uploads an image from assets/ into the bound GL_TEXTURE_2D, taking the
+//  cooked copy (see CookedTexture.h and tools/assetCooker) when there is an
+//  up-to-date one the driver can sample: that is a file read and one
+//  glCompressedTexImage2D / glTexImage2D per mip level, with no PNG decode.
+//  Otherwise the PNG is decoded as before and prepared the same way the
+//  cooker would, so a missing or stale cooked file only costs load time.
+//
+//  Up to date means the source's FNV-1a hash is the one the cooker wrote to
+//  assets/cooked/manifest.txt, so a checkout or copy that touches every
+//  file does not make the cooked copies look stale, and an edited source
+//  with an older timestamp is not mistaken for a cooked one. The source is
+//  read once for the hash and, if needed, decoded from the same bytes.
+//
+//  A cooked copy made with other alpha handling than `flags` is skipped
+//  quietly: two programs may want the same image prepared differently, and
+//  the rules can only cook it one way.
+//
+//  If the caller set a mipmap MIN_FILTER and the upload has a single level
+//  (the PNG, or an RGBA8 copy cooked without mips) the chain is generated
+//  with glGenerateMipmap, as the loaders did before.
+//
+//      glGenTextures(1, &tex);
+//      glState.bindTexture(0, GL_TEXTURE_2D, tex);
+//      ... wrap and filter parameters ...
+//      TextureInfo info = uploadTexture("../assets/sprites/a.png", TEXTURE_CUTOUT | TEXTURE_PREMULTIPLY);
+//
+//  Rows are uploaded top row first, as stb_image returns them unflipped.
+//  Binding is left to the caller, so it goes through the caller's state
+//  cache.
+//
+
+#ifndef TextureLoader_h
+#define TextureLoader_h
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include "CookedTexture.h"
+
+enum TextureFlags {
+    TEXTURE_CUTOUT      = 1,   // alpha under 128 becomes fully transparent
+    TEXTURE_PREMULTIPLY = 2,   // colour multiplied by alpha
+};
+
+struct TextureInfo {
+    int width = 0, height = 0;
+    int levels = 0;           // 0 if nothing was uploaded
+    bool cooked = false;
+};
+
+// Whether the driver can sample a cooked format.
+inline bool cookedFormatSupported(uint32_t format) {
+    switch (format) {
+        case CTEX_RGBA8: return true;
+        case CTEX_BC1:
+        case CTEX_BC3:   return GLAD_GL_EXT_texture_compression_s3tc != 0;
+        case CTEX_BC7:   return GLAD_GL_ARB_texture_compression_bptc != 0 || GLAD_GL_VERSION_4_2 != 0;
+    }
+    return false;
+}
+
+inline GLenum cookedInternalFormat(uint32_t format) {
+    switch (format) {
+        case CTEX_BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case CTEX_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case CTEX_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return GL_RGBA8;
+}
+
+// Source hashes from the cooker's manifest, read once per cooked directory.
+inline const std::map<std::string, uint64_t>& cookedManifest(const std::string& cookedDir) {
+    static std::map<std::string, std::map<std::string, uint64_t>> manifests;
+    auto found = manifests.find(cookedDir);
+    if (found != manifests.end()) return found->second;
+    std::map<std::string, uint64_t>& hashes = manifests[cookedDir];
+    std::ifstream manifest(cookedDir + "manifest.txt");
+    std::string line;
+    while (std::getline(manifest, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream in(line);
+        std::string relative;
+        uint64_t sourceHash;
+        in >> relative >> std::hex >> sourceHash;
+        if (in) hashes[relative] = sourceHash;
+    }
+    return hashes;
+}
+
+// Whether the cooker's manifest lists `sourcePath` with this content.
+inline bool cookedCopyCurrent(const std::string& sourcePath, const std::string& sourceBytes) {
+    size_t at = sourcePath.find("assets/");
+    if (at == std::string::npos) return false;
+    const std::map<std::string, uint64_t>& hashes = cookedManifest(sourcePath.substr(0, at + 7) + "cooked/");
+    auto found = hashes.find(sourcePath.substr(at + 7));
+    return found != hashes.end() && found->second == fnv1a64(sourceBytes.data(), sourceBytes.size());
+}
+
+inline bool wantsMipmaps() {
+    GLint filter;
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
+    return filter != GL_NEAREST && filter != GL_LINEAR;
+}
+
+// Full chain for the single level just uploaded; returns the level count.
+inline int generateMipmaps(int width, int height) {
+    int levels = 1;
+    while ((width | height) >> levels) ++levels;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    return levels;
+}
+
+// Returns false (and uploads nothing) if there is no usable cooked copy:
+// missing, not cooked from these source bytes, unsupported here, or cooked
+// with other alpha handling than `flags` asks for.
+inline bool uploadCookedTexture(const std::string& sourcePath, const std::string& sourceBytes, int flags, TextureInfo& info) {
+    std::string cookedPath = cookedPathFor(sourcePath);
+    if (cookedPath.empty() || !cookedCopyCurrent(sourcePath, sourceBytes)) return false;
+    CookedTexture texture;
+    if (!texture.load(cookedPath)) {
+        std::cerr << "Textura cozida invalida: " << cookedPath << std::endl;
+        return false;
+    }
+    if (!cookedFormatSupported(texture.format)) return false;
+    if (texture.premultiplied() != ((flags & TEXTURE_PREMULTIPLY) != 0) ||
+        texture.cutout() != ((flags & TEXTURE_CUTOUT) != 0)) return false;
+    GLint alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    GLenum internalFormat = cookedInternalFormat(texture.format);
+    for (size_t i = 0; i < texture.levels.size(); ++i) {
+        const CookedLevel& level = texture.levels[i];
+        if (texture.format == CTEX_RGBA8)
+            glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+        else
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, internalFormat, level.width, level.height, 0, (GLsizei)level.size, level.data);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    info.width = (int)texture.width;
+    info.height = (int)texture.height;
+    info.levels = (int)texture.levels.size();
+    info.cooked = true;
+    if (info.levels == 1 && texture.format == CTEX_RGBA8 && wantsMipmaps())
+        info.levels = generateMipmaps(info.width, info.height);
+    else
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, info.levels - 1);
+    return true;
+}
+
+// Cooked copy if possible, else the source image (with mipmaps if the
+// filter asks for them).
+inline TextureInfo uploadTexture(const std::string& path, int flags = 0) {
+    TextureInfo info;
+    std::ifstream file(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!file || bytes.empty()) {
+        std::cerr << "Erro ao carregar textura " << path << std::endl;
+        return info;
+    }
+    if (uploadCookedTexture(path, bytes, flags, info)) return info;
+    int channels;
+    unsigned char* data = stbi_load_from_memory((const unsigned char*)bytes.data(), (int)bytes.size(),
+                                                &info.width, &info.height, &channels, 4);
+    if (!data) {
+        std::cerr << "Erro ao carregar textura " << path << std::endl;
+        return info;
+    }
+    prepareTexels(data, (size_t)info.width * info.height, (flags & TEXTURE_CUTOUT) != 0, (flags & TEXTURE_PREMULTIPLY) != 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, info.width, info.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    stbi_image_free(data);
+    info.levels = 1;
+    if (wantsMipmaps())
+        info.levels = generateMipmaps(info.width, info.height);
+    else
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    return info;
+}
+
+#endif /* TextureLoader_h */
@@ -0,0 +1,103 @@
+//
+//  UniformBuffers.h
+//  Uniform blocks shared by the 2D shaders: per-frame constants uploaded
+//  once per frame and the sprite-sheet UV table that shaders index by
+//  frame number.
+//
+
+#ifndef UniformBuffers_h
+#define UniformBuffers_h
+
+#include <glad/glad.h>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "GLStateCache.h"
+
+// --- UNIFORM BLOCK BINDING POINTS ---
+const GLuint FRAME_UBO_BINDING     = 0;
+const GLuint SPRITE_UV_UBO_BINDING = 1;
+
+// 16 KB, the smallest GL_MAX_UNIFORM_BLOCK_SIZE GL 3.3 allows. The macro
+// is for the GLSL string below; code uses the constant.
+#define MAX_SPRITE_FRAMES_GLSL 1024
+#define UBO_GLSL_STRING(x) #x
+#define UBO_GLSL_NUMBER(x) UBO_GLSL_STRING(x)
+const int MAX_SPRITE_FRAMES = MAX_SPRITE_FRAMES_GLSL;
+
+// --- GLSL DECLARATIONS (std140, must match the structs below) ---
+#define FRAME_DATA_GLSL "layout (std140) uniform FrameData { mat4 projection; vec4 viewport; float time; };\n"
+#define SPRITE_UV_GLSL  "layout (std140) uniform SpriteFrames { vec4 frameUV[" UBO_GLSL_NUMBER(MAX_SPRITE_FRAMES_GLSL) "]; };\n"
+
+struct FrameUniforms {
+    glm::mat4 projection;
+    glm::vec4 viewport;   // x, y, width, height
+    float time;
+    float pad[3];
+};
+
+// Points the FrameData/SpriteFrames blocks of a linked program at their binding slots.
+inline void bindUniformBlocks(GLuint program) {
+    GLuint frameIndex = glGetUniformBlockIndex(program, "FrameData");
+    if (frameIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, frameIndex, FRAME_UBO_BINDING);
+    GLuint spriteIndex = glGetUniformBlockIndex(program, "SpriteFrames");
+    if (spriteIndex != GL_INVALID_INDEX) glUniformBlockBinding(program, spriteIndex, SPRITE_UV_UBO_BINDING);
+}
+
+class FrameUniformBuffer {
+public:
+    void init() {
+        glGenBuffers(1, &ubo);
+        glState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glState.bindBufferBase(GL_UNIFORM_BUFFER, FRAME_UBO_BINDING, ubo);
+    }
+
+    void update(const glm::mat4& projection, float time, int width, int height) {
+        FrameUniforms data;
+        data.projection = projection;
+        data.viewport   = glm::vec4(0.0f, 0.0f, (float)width, (float)height);
+        data.time       = time;
+        glState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+    }
+
+    // Call before glfwTerminate; nothing is freed on destruction.
+    void destroy() {
+        glState.forgetBuffer(ubo);
+        glDeleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+
+private:
+    GLuint ubo = 0;
+};
+
+// Every frame rect of the loaded sprite sheets (u0, v0, u1, v1), uploaded
+// once. A shader reads frameUV[frame], so changing a sprite's frame is a
+// single integer uniform or vertex attribute instead of new vertices.
+class SpriteUVTable {
+public:
+    // `rects` holds four floats per frame; frames past MAX_SPRITE_FRAMES are dropped.
+    void init(const float* rects, int frames) {
+        count = std::min(frames, MAX_SPRITE_FRAMES);
+        glGenBuffers(1, &ubo);
+        glState.bindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_SPRITE_FRAMES * 4 * sizeof(float), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, count * 4 * sizeof(float), rects);
+        glState.bindBufferBase(GL_UNIFORM_BUFFER, SPRITE_UV_UBO_BINDING, ubo);
+    }
+
+    int size() const { return count; }
+
+    void destroy() {
+        glState.forgetBuffer(ubo);
+        glDeleteBuffers(1, &ubo);
+        ubo = 0;
+    }
+
+private:
+    GLuint ubo = 0;
+    int count = 0;
+};
+
+#endif /* UniformBuffers_h */
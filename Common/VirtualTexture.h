@@ -0,0 +1,417 @@
+//
+//  VirtualTexture.h
+//  Images larger than the GPU can (or should) hold, paged in on demand.
+//  importVirtualTexture() slices an image once into fixed-size pages and
+//  writes them to a .vtex file together with a small downscaled copy.
+//  A PageCache keeps the pages the camera needs in one atlas texture of a
+//  fixed number of slots, least recently used first out, and reads missing
+//  pages from disk on a worker thread; until a page arrives, callers draw
+//  that area from the downscaled copy. Video memory is the atlas plus the
+//  small copies, whatever the size of the images.
+//
+//  The slot bookkeeping and the reads live in PageTable, which makes no GL
+//  calls; PageCache adds the textures around it. Tools use PageTable alone.
+//
+//  .vtex file: "VTEX", then uint32 version, width, height, page size,
+//  fallback width and height; the fallback image (RGBA); then every page,
+//  row-major, as (page + 2)^2 RGBA pixels: each page carries a one-pixel
+//  border copied from its neighbours, so bilinear filtering doesn't bleed
+//  between atlas slots.
+//
+//  Per frame, on the GL thread:
+//      cache.beginFrame();                     // uploads pages that arrived
+//      int slot = cache.lookup(source, col, row);
+//      if (slot < 0) cache.want(source, col, row, true);   // draw the fallback
+//      ...
+//      cache.endFrame();                       // queues the missing pages
+//
+
+#ifndef VirtualTexture_h
+#define VirtualTexture_h
+
+#include <glad/glad.h>
+#include <stb_image.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ThreadPool.h"
+
+const uint32_t VTEX_VERSION = 1;
+const int VTEX_FALLBACK_SIZE = 1024;   // longest side of the downscaled copy
+
+struct VirtualTextureInfo {
+    uint32_t width = 0, height = 0, pageSize = 0;
+    uint32_t fallbackWidth = 0, fallbackHeight = 0;
+
+    uint32_t pagesX() const { return (width + pageSize - 1) / pageSize; }
+    uint32_t pagesY() const { return (height + pageSize - 1) / pageSize; }
+    size_t pageBytes() const { return (size_t)(pageSize + 2) * (pageSize + 2) * 4; }
+    size_t pageOffset(uint32_t col, uint32_t row) const {
+        return 28 + (size_t)fallbackWidth * fallbackHeight * 4 + ((size_t)row * pagesX() + col) * pageBytes();
+    }
+};
+
+inline bool readVirtualTextureInfo(std::istream& in, VirtualTextureInfo& info) {
+    char magic[4];
+    uint32_t header[6];
+    if (!in.read(magic, 4) || std::string(magic, 4) != "VTEX" || !in.read((char*)header, sizeof(header))) return false;
+    info.width = header[1]; info.height = header[2]; info.pageSize = header[3];
+    info.fallbackWidth = header[4]; info.fallbackHeight = header[5];
+    return header[0] == VTEX_VERSION && info.pageSize > 0;
+}
+
+// True if `vtexPath` exists, was written after `imagePath` and uses `pageSize`.
+inline bool virtualTextureUpToDate(const std::string& imagePath, const std::string& vtexPath, int pageSize) {
+    struct stat image, vtex;
+    if (stat(imagePath.c_str(), &image) != 0 || stat(vtexPath.c_str(), &vtex) != 0 || vtex.st_mtime < image.st_mtime) return false;
+    std::ifstream in(vtexPath, std::ios::binary);
+    VirtualTextureInfo info;
+    return readVirtualTextureInfo(in, info) && info.pageSize == (uint32_t)pageSize;
+}
+
+// Decodes the image once and writes its pages; this is the only time the
+// whole image is in memory.
+inline bool importVirtualTexture(const std::string& imagePath, const std::string& vtexPath, int pageSize) {
+    int w, h, channels;
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char* pixels = stbi_load(imagePath.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        std::cerr << "Falha ao carregar " << imagePath << std::endl;
+        return false;
+    }
+    FILE* file = fopen(vtexPath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Erro ao criar " << vtexPath << std::endl;
+        stbi_image_free(pixels);
+        return false;
+    }
+    VirtualTextureInfo info;
+    info.width = w; info.height = h; info.pageSize = pageSize;
+    int factor = std::max(1, (std::max(w, h) + VTEX_FALLBACK_SIZE - 1) / VTEX_FALLBACK_SIZE);
+    info.fallbackWidth = (w + factor - 1) / factor;
+    info.fallbackHeight = (h + factor - 1) / factor;
+    uint32_t header[6] = { VTEX_VERSION, info.width, info.height, info.pageSize, info.fallbackWidth, info.fallbackHeight };
+    fwrite("VTEX", 1, 4, file);
+    fwrite(header, sizeof(header), 1, file);
+
+    // box-filtered fallback
+    std::vector<unsigned char> buffer((size_t)info.fallbackWidth * info.fallbackHeight * 4);
+    for (uint32_t y = 0; y < info.fallbackHeight; ++y) {
+        for (uint32_t x = 0; x < info.fallbackWidth; ++x) {
+            uint32_t sum[4] = {}, count = 0;
+            for (int sy = y * factor; sy < std::min<int>(h, (y + 1) * factor); ++sy)
+                for (int sx = x * factor; sx < std::min<int>(w, (x + 1) * factor); ++sx, ++count)
+                    for (int c = 0; c < 4; ++c) sum[c] += pixels[((size_t)sy * w + sx) * 4 + c];
+            for (int c = 0; c < 4; ++c) buffer[((size_t)y * info.fallbackWidth + x) * 4 + c] = (unsigned char)(sum[c] / count);
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), file);
+
+    // pages with a clamped one-pixel border
+    int stride = pageSize + 2;
+    buffer.resize(info.pageBytes());
+    for (uint32_t row = 0; row < info.pagesY(); ++row) {
+        for (uint32_t col = 0; col < info.pagesX(); ++col) {
+            for (int y = 0; y < stride; ++y) {
+                int sy = std::min(std::max((int)(row * pageSize) + y - 1, 0), h - 1);
+                for (int x = 0; x < stride; ++x) {
+                    int sx = std::min(std::max((int)(col * pageSize) + x - 1, 0), w - 1);
+                    memcpy(&buffer[((size_t)y * stride + x) * 4], &pixels[((size_t)sy * w + sx) * 4], 4);
+                }
+            }
+            fwrite(buffer.data(), 1, buffer.size(), file);
+        }
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    stbi_image_free(pixels);
+    return ok;
+}
+
+// --- PAGE TABLE ---
+class PageTable {
+public:
+    static const int MAX_UPLOADS_PER_FRAME = 4;
+
+    // Up to `maxPages` slots, laid out in atlas rows of at most `maxTexture` pixels.
+    void init(int pageSize, int maxPages, int maxTexture = 4096) {
+        this->pageSize = pageSize;
+        int stride = pageSize + 2;
+        int limit = maxTexture / stride;
+        slotsPerRow = std::min(limit, std::max(1, (int)std::ceil(std::sqrt((double)maxPages))));
+        int rows = std::min(limit, (maxPages + slotsPerRow - 1) / slotsPerRow);
+        slots.assign(std::min(maxPages, slotsPerRow * rows), Slot());
+        atlasWidth = slotsPerRow * stride;
+        atlasHeight = rows * stride;
+    }
+
+    // Opens a .vtex made with the same page size and, if asked, reads its
+    // fallback image into `fallback`. Returns the source id, or -1.
+    int addSource(const std::string& vtexPath, std::vector<unsigned char>* fallback = nullptr) {
+        std::unique_ptr<Source> source(new Source());
+        source->file.open(vtexPath, std::ios::binary);
+        if (!readVirtualTextureInfo(source->file, source->info) || source->info.pageSize != (uint32_t)pageSize) {
+            std::cerr << "Arquivo de paginas invalido: " << vtexPath << std::endl;
+            return -1;
+        }
+        if (fallback) {
+            fallback->resize((size_t)source->info.fallbackWidth * source->info.fallbackHeight * 4);
+            source->file.read((char*)fallback->data(), fallback->size());
+        }
+        if (!loader) loader.reset(new ThreadPool(1));
+        sources.push_back(std::move(source));
+        return (int)sources.size() - 1;
+    }
+
+    // Places up to MAX_UPLOADS_PER_FRAME pages read since the last frame and
+    // calls upload(slot, pixels) for each. A page only replaces one that
+    // wasn't drawn in the previous frame; if there is none, it is dropped
+    // and asked for again later.
+    template <class Upload>
+    void beginFrame(Upload upload) {
+        frame++;
+        std::vector<LoadedPage> arrived;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t n = std::min(loaded.size(), (size_t)MAX_UPLOADS_PER_FRAME);
+            arrived.assign(std::make_move_iterator(loaded.begin()), std::make_move_iterator(loaded.begin() + n));
+            loaded.erase(loaded.begin(), loaded.begin() + n);
+            for (const LoadedPage& page : arrived) requested.erase(page.key);
+        }
+        for (LoadedPage& page : arrived) {
+            if (resident.count(page.key) || page.pixels.empty()) continue;
+            int slot = -1;
+            for (int i = 0; i < (int)slots.size(); ++i) {
+                if (slots[i].key == EMPTY) { slot = i; break; }
+                if (slots[i].lastUsed + 1 < frame && (slot < 0 || slots[i].lastUsed < slots[slot].lastUsed)) slot = i;
+            }
+            if (slot < 0) continue;
+            if (slots[slot].key != EMPTY) resident.erase(slots[slot].key);
+            slots[slot].key = page.key;
+            slots[slot].lastUsed = frame - 1;
+            resident[page.key] = slot;
+            upload(slot, page.pixels.data());
+            uploads++;
+        }
+    }
+
+    void beginFrame() { beginFrame([](int, const unsigned char*) {}); }
+
+    // Slot holding the page, marked as used this frame; -1 if not resident.
+    int lookup(int source, int col, int row) {
+        auto it = resident.find(makeKey(source, col, row));
+        if (it == resident.end()) return -1;
+        slots[it->second].lastUsed = frame;
+        return it->second;
+    }
+
+    // Asks for a page; `visible` pages are read before prefetched ones.
+    void want(int source, int col, int row, bool visible) {
+        uint64_t key = makeKey(source, col, row);
+        if (!resident.count(key)) (visible ? wantedVisible : wantedPrefetch).push_back(key);
+    }
+
+    // Queues reads for what was wanted this frame, visible pages first, but
+    // no more than there are slots not drawn this frame minus the reads
+    // already on their way: a page with no slot to land in would be dropped
+    // and read again, every frame while the view stays put. Reads still
+    // waiting for pages nobody wants anymore are skipped by the worker.
+    void endFrame() {
+        std::lock_guard<std::mutex> lock(mutex);
+        wanted.clear();
+        wanted.insert(wantedVisible.begin(), wantedVisible.end());
+        int drawn = 0;
+        for (const Slot& slot : slots) drawn += slot.key != EMPTY && slot.lastUsed >= frame;
+        if (drawn + (int)wanted.size() > (int)slots.size() && !warnedCapacity) {
+            std::cerr << "Paginas visiveis (" << drawn + wanted.size() << ") acima da capacidade do cache ("
+                      << slots.size() << "); partes da imagem ficam em baixa resolucao" << std::endl;
+            warnedCapacity = true;
+        }
+        wanted.insert(wantedPrefetch.begin(), wantedPrefetch.end());
+        int budget = (int)slots.size() - drawn - (int)requested.size();
+        for (const std::vector<uint64_t>* list : { &wantedVisible, &wantedPrefetch }) {
+            for (uint64_t key : *list) {
+                if (budget <= 0) break;
+                if (!requested.insert(key).second) continue;
+                Source* source = sources[key >> 40].get();
+                loader->submit([this, source, key] { read(source, key); });
+                budget--;
+            }
+        }
+        wantedVisible.clear();
+        wantedPrefetch.clear();
+    }
+
+    // Top-left pixel of `slot` in the atlas, border included.
+    int slotX(int slot) const { return (slot % slotsPerRow) * (pageSize + 2); }
+    int slotY(int slot) const { return (slot / slotsPerRow) * (pageSize + 2); }
+
+    // Texture coordinates in the atlas of the pixel rectangle (x0, y0)-(x1, y1)
+    // of the page in `slot`.
+    void slotUV(int slot, float x0, float y0, float x1, float y1, float uv[4]) const {
+        float left = (float)(slotX(slot) + 1);
+        float top = (float)(slotY(slot) + 1);
+        uv[0] = (left + x0) / atlasWidth;  uv[1] = (top + y0) / atlasHeight;
+        uv[2] = (left + x1) / atlasWidth;  uv[3] = (top + y1) / atlasHeight;
+    }
+
+    const VirtualTextureInfo& info(int source) const { return sources[source]->info; }
+    int pageStride() const { return pageSize + 2; }
+    int width() const { return atlasWidth; }
+    int height() const { return atlasHeight; }
+    int capacity() const { return (int)slots.size(); }
+    int residentPages() const { return (int)resident.size(); }
+    unsigned uploadCount() const { return uploads; }
+    unsigned readCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reads;
+    }
+
+    void destroy() {
+        loader.reset();
+        sources.clear();
+        resident.clear();
+        slots.clear();
+    }
+
+private:
+    static const uint64_t EMPTY = ~0ull;
+    struct Source {
+        VirtualTextureInfo info;
+        std::ifstream file;   // read by the worker only, after creation
+    };
+    struct Slot {
+        uint64_t key = EMPTY;
+        uint64_t lastUsed = 0;
+    };
+    struct LoadedPage {
+        uint64_t key;
+        std::vector<unsigned char> pixels;   // empty if the read failed
+    };
+
+    static uint64_t makeKey(int source, int col, int row) {
+        return ((uint64_t)source << 40) | ((uint64_t)row << 20) | (uint64_t)col;
+    }
+
+    // Worker thread.
+    void read(Source* source, uint64_t key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!wanted.count(key)) {
+                requested.erase(key);
+                return;
+            }
+        }
+        const VirtualTextureInfo& info = source->info;
+        LoadedPage page;
+        page.key = key;
+        page.pixels.resize(info.pageBytes());
+        source->file.clear();
+        source->file.seekg((std::streamoff)info.pageOffset(key & 0xFFFFF, (key >> 20) & 0xFFFFF));
+        if (!source->file.read((char*)page.pixels.data(), page.pixels.size())) page.pixels.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        reads++;
+        loaded.push_back(std::move(page));
+    }
+
+    int pageSize = 0, slotsPerRow = 1, atlasWidth = 0, atlasHeight = 0;
+    bool warnedCapacity = false;
+    uint64_t frame = 1;
+    unsigned uploads = 0;
+    std::vector<std::unique_ptr<Source>> sources;
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, int> resident;
+    std::vector<uint64_t> wantedVisible, wantedPrefetch;
+    // shared with the worker
+    std::mutex mutex;
+    std::unordered_set<uint64_t> wanted, requested;
+    std::vector<LoadedPage> loaded;
+    unsigned reads = 0;
+    std::unique_ptr<ThreadPool> loader;   // last, so it stops first
+};
+
+// --- PAGE CACHE ---
+class PageCache {
+public:
+    // `maxPages` is the budget: the atlas never holds more, and it is
+    // lowered if the atlas wouldn't fit GL_MAX_TEXTURE_SIZE.
+    void init(int pageSize, int maxPages, GLenum textureFilter = GL_LINEAR) {
+        filter = textureFilter;
+        GLint maxTexture = 4096;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+        table.init(pageSize, maxPages, maxTexture);
+        atlasTexture = createTexture(table.width(), table.height(), nullptr);
+    }
+
+    // Opens a .vtex made with the same page size and uploads its fallback.
+    // Returns the source id, or -1.
+    int addSource(const std::string& vtexPath) {
+        std::vector<unsigned char> pixels;
+        int source = table.addSource(vtexPath, &pixels);
+        if (source < 0) return -1;
+        fallbacks.push_back(createTexture(info(source).fallbackWidth, info(source).fallbackHeight, pixels.data()));
+        return source;
+    }
+
+    // Uploads the pages the table placed this frame into their atlas slots.
+    void beginFrame() {
+        int stride = table.pageStride();
+        table.beginFrame([&](int slot, const unsigned char* pixels) {
+            glBindTexture(GL_TEXTURE_2D, atlasTexture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, table.slotX(slot), table.slotY(slot), stride, stride,
+                            GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        });
+    }
+
+    int lookup(int source, int col, int row) { return table.lookup(source, col, row); }
+    void want(int source, int col, int row, bool visible) { table.want(source, col, row, visible); }
+    void endFrame() { table.endFrame(); }
+    void slotUV(int slot, float x0, float y0, float x1, float y1, float uv[4]) const { table.slotUV(slot, x0, y0, x1, y1, uv); }
+
+    GLuint atlas() const { return atlasTexture; }
+    GLuint fallback(int source) const { return fallbacks[source]; }
+    const VirtualTextureInfo& info(int source) const { return table.info(source); }
+    int capacity() const { return table.capacity(); }
+    int residentPages() const { return table.residentPages(); }
+    size_t budgetBytes() const { return (size_t)table.width() * table.height() * 4; }
+    unsigned uploadCount() const { return table.uploadCount(); }
+
+    void destroy() {
+        table.destroy();
+        glDeleteTextures(1, &atlasTexture);
+        if (!fallbacks.empty()) glDeleteTextures((GLsizei)fallbacks.size(), fallbacks.data());
+        atlasTexture = 0;
+        fallbacks.clear();
+    }
+
+private:
+    GLuint createTexture(int width, int height, const unsigned char* data) {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        return texture;
+    }
+
+    PageTable table;
+    GLuint atlasTexture = 0;
+    GLenum filter = GL_LINEAR;
+    std::vector<GLuint> fallbacks;
+};
+
+#endif /* VirtualTexture_h */
@@ -18,8 +18,10 @@
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <string>
+#include "ShaderCache.h"
+#include "ShaderSource.h"
 #define GL_LOG_FILE "gl.log"
-#define MAX_SHADER_LENGTH 262144
 
 /*--------------------------------LOG FUNCTIONS-------------------------------*/
 bool restart_gl_log () {
@@ -160,6 +162,9 @@ void _update_fps_counter (GLFWwindow* window) {
 }
 
 /*-----------------------------------SHADERS----------------------------------*/
+/* reads the whole file with one fread; kept for callers with their own
+buffer. files with #include or #define permutations go through shaderLoader
+(ShaderSource.h) instead */
 bool parse_file_into_str (
 	const char* file_name, char* shader_str, int max_len
 ) {
@@ -169,26 +174,20 @@ bool parse_file_into_str (
 		gl_log_err ("ERROR: opening file for reading: %s\n", file_name);
 		return false;
 	}
-	int current_len = 0;
-	char line[2048];
-	strcpy (line, ""); // remember to clean up before using for first time!
-	while (!feof (file)) {
-		if (NULL != fgets (line, 2048, file)) {
-			current_len += strlen (line); // +1 for \n at end
-			if (current_len >= max_len) {
-				gl_log_err (
-					"ERROR: shader length is longer than string buffer length %i\n",
-					max_len
-				);
-			}
-			strcat (shader_str, line);
-		}
+	size_t len = fread (shader_str, 1, max_len - 1, file);
+	shader_str[len] = '\0';
+	bool too_long = EOF != fgetc (file);
+	if (too_long) {
+		gl_log_err (
+			"ERROR: shader length is longer than string buffer length %i\n",
+			max_len
+		);
 	}
 	if (EOF == fclose (file)) { // probably unnecesssary validation
 		gl_log_err ("ERROR: closing file from reading %s\n", file_name);
 		return false;
 	}
-	return true;
+	return !too_long;
 }
 
 void print_shader_info_log (GLuint shader_index) {
@@ -202,10 +201,13 @@ void print_shader_info_log (GLuint shader_index) {
 
 bool create_shader (const char* file_name, GLuint* shader, GLenum type) {
 	gl_log ("creating shader from %s...\n", file_name);
-	char shader_string[MAX_SHADER_LENGTH];
-	assert (parse_file_into_str (file_name, shader_string, MAX_SHADER_LENGTH));
+	ShaderSource source;
+	if (!shaderLoader.load (file_name, source)) {
+		gl_log_err ("ERROR: %s\n", source.error.c_str ());
+		return false;
+	}
 	*shader = glCreateShader (type);
-	const GLchar* p = (const GLchar*)shader_string;
+	const GLchar* p = (const GLchar*)source.text.c_str ();
 	glShaderSource (*shader, 1, &p, NULL);
 	glCompileShader (*shader);
 	// check for compile errors
@@ -213,7 +215,9 @@ bool create_shader (const char* file_name, GLuint* shader, GLenum type) {
 	glGetShaderiv (*shader, GL_COMPILE_STATUS, &params);
 	if (GL_TRUE != params) {
 		gl_log_err ("ERROR: GL shader index %i did not compile\n", *shader);
-		print_shader_info_log (*shader);
+		char log[2048];
+		glGetShaderInfoLog (*shader, sizeof (log), NULL, log);
+		gl_log_err ("shader info log for %s:\n%s\n", file_name, source.translateLog (log).c_str ());
 		return false; // or exit or something
 	}
 	gl_log ("shader compiled. index %i\n", *shader);
@@ -271,12 +275,22 @@ bool create_programme (GLuint vert, GLuint frag, GLuint* programme) {
 	return true;
 }
 
+/* goes through the shader binary cache (ShaderCache.h): a relaunch with the
+same files and driver loads the linked binary instead of compiling */
 GLuint create_programme_from_files (
 	const char* vert_file_name, const char* frag_file_name
 ) {
-	GLuint vert, frag, programme;
-	assert (create_shader (vert_file_name, &vert, GL_VERTEX_SHADER));
-	assert (create_shader (frag_file_name, &frag, GL_FRAGMENT_SHADER));
-	assert (create_programme (vert, frag, &programme));
+	ShaderSource vert, frag;
+	if (!shaderLoader.load (vert_file_name, vert) || !shaderLoader.load (frag_file_name, frag)) {
+		gl_log_err ("ERROR: %s\n", (vert.error.empty () ? frag.error : vert.error).c_str ());
+		return 0;
+	}
+	std::string name = std::string (vert_file_name) + "+" + frag_file_name;
+	for (char& c : name) {
+		if (c == '/' || c == '\\') { c = '_'; }
+	}
+	GLuint programme = shaderCache.build (name, vert, frag);
+	assert (programme);
+	gl_log ("programme %u from %s and %s\n", programme, vert_file_name, frag_file_name);
 	return programme;
 }
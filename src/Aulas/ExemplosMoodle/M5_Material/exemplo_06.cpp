@@ -2,6 +2,7 @@
 //#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "gl_utils.h"
+#include "ShaderSource.h"
 #include <glad/glad.h> // Carregamento dos ponteiros para funções OpenGL
 #include <GLFW/glfw3.h>
 #include <assert.h>
@@ -66,13 +67,16 @@ int main()
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	char vertex_shader[1024 * 256];
-	char fragment_shader[1024 * 256];
-	parse_file_into_str("_sprites_vs.glsl", vertex_shader, 1024 * 256);
-	parse_file_into_str("_sprites_fs.glsl", fragment_shader, 1024 * 256);
+	ShaderSource vertex_shader, fragment_shader;
+	if (!shaderLoader.load("_sprites_vs.glsl", vertex_shader) ||
+		!shaderLoader.load("_sprites_fs.glsl", fragment_shader))
+	{
+		fprintf(stderr, "ERROR: %s\n", (vertex_shader.error.empty() ? fragment_shader.error : vertex_shader.error).c_str());
+		return 1;
+	}
 
 	GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-	const GLchar *p = (const GLchar *)vertex_shader;
+	const GLchar *p = (const GLchar *)vertex_shader.text.c_str();
 	glShaderSource(vs, 1, &p, NULL);
 	glCompileShader(vs);
 
@@ -87,7 +91,7 @@ int main()
 	}
 
 	GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-	p = (const GLchar *)fragment_shader;
+	p = (const GLchar *)fragment_shader.text.c_str();
 	glShaderSource(fs, 1, &p, NULL);
 	glCompileShader(fs);
 
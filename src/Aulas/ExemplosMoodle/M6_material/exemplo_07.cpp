@@ -1,6 +1,8 @@
 //#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "gl_utils.h"
+#include "InputQueue.h"
+#include "ShaderRegistry.h"
 #include <glad/glad.h> // Carregamento dos ponteiros para funções OpenGL
 #include <GLFW/glfw3.h>
 #include <assert.h>
@@ -45,6 +47,7 @@ TilemapView *tview = new DiamondView();
 TileMap *tmap = NULL;
 
 GLFWwindow *g_window = NULL;
+InputQueue clicks;   // left-button presses, one pick per click
 
 TileMap * readMap (char *filename) {
     ifstream arq(filename);
@@ -183,11 +186,19 @@ void mouse(double &mx, double &my) {
     cx = c; cy = r;
 }
 
+void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+	if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+	double mx, my;
+	glfwGetCursorPos(window, &mx, &my);
+	clicks.push(InputEvent::mouseButton(glfwGetTime(), button, action, mods, mx, my));
+}
+
 int main()
 {
 	restart_gl_log();
 	// all the GLFW and GLEW start-up code is moved to here in gl_utils.cpp
 	start_gl();
+	glfwSetMouseButtonCallback(g_window, mouse_button_callback);
 	// tell GL to only draw onto a pixel if the shape is closer to the viewer
 	glEnable(GL_DEPTH_TEST); // enable depth-testing
 	glDepthFunc(GL_LESS);
@@ -250,53 +261,11 @@ int main()
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-    char vertex_shader[1024 * 256];
-	char fragment_shader[1024 * 256];
-	parse_file_into_str("_geral_vs.glsl", vertex_shader, 1024 * 256);
-	parse_file_into_str("_geral_fs.glsl", fragment_shader, 1024 * 256);
-
-	GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-	const GLchar *p = (const GLchar *)vertex_shader;
-	glShaderSource(vs, 1, &p, NULL);
-	glCompileShader(vs);
-
-	// check for compile errors
-	int params = -1;
-	glGetShaderiv(vs, GL_COMPILE_STATUS, &params);
-	if (GL_TRUE != params)
-	{
-		fprintf(stderr, "ERROR: GL shader index %i did not compile\n", vs);
-		print_shader_info_log(vs);
-		return 1; // or exit or something
-	}
-
-	GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-	p = (const GLchar *)fragment_shader;
-	glShaderSource(fs, 1, &p, NULL);
-	glCompileShader(fs);
-
-	// check for compile errors
-	glGetShaderiv(fs, GL_COMPILE_STATUS, &params);
-	if (GL_TRUE != params)
-	{
-		fprintf(stderr, "ERROR: GL shader index %i did not compile\n", fs);
-		print_shader_info_log(fs);
-		return 1; // or exit or something
-	}
-
-	GLuint shader_programme = glCreateProgram();
-	glAttachShader(shader_programme, fs);
-	glAttachShader(shader_programme, vs);
-	glLinkProgram(shader_programme);
-
-	glGetProgramiv(shader_programme, GL_LINK_STATUS, &params);
-	if (GL_TRUE != params)
-	{
-		fprintf(stderr, "ERROR: could not link shader programme GL index %i\n",
-				shader_programme);
-		// 		print_programme_info_log( shader_programme );
-		return false;
-	}
+	// rebuilt whenever the .glsl files are saved; a shader that doesn't
+	// compile leaves the previous programme (or none, at start) in use
+	ShaderRegistry shaders;
+	shaders.startWorker(g_window);   // compiles off the frame loop without KHR_parallel_shader_compile
+	int geral = shaders.add("exemplo_07", "_geral_vs.glsl", "_geral_fs.glsl");
 
 	float previous = glfwGetTime();
     
@@ -324,12 +293,14 @@ int main()
 
 		glViewport(0, 0, g_gl_width, g_gl_height);
 
+		shaders.poll();
+		GLuint shader_programme = shaders.program(geral);
 		glUseProgram(shader_programme);
 
 		glBindVertexArray(VAO);
         float x, y;
         int r = 0, c = 0;
-        for(int r = 0; r < tmap->getHeight(); r++) {
+        for(int r = 0; shader_programme && r < tmap->getHeight(); r++) {
             for(int c = 0; c < tmap->getWidth(); c++) {
                 int t_id = (int) tmap->getTile(c, r);
                 int u = t_id % tileSetCols;
@@ -364,12 +335,9 @@ int main()
 		if (GLFW_PRESS == glfwGetKey(g_window, GLFW_KEY_DOWN))
 		{
 		}
-        double mx, my;
-        glfwGetCursorPos(g_window, &mx, &my);
-        
-        const int state = glfwGetMouseButton(g_window, GLFW_MOUSE_BUTTON_LEFT);
-        
-        if (state == GLFW_PRESS) {
+        InputEvent click;
+        while (clicks.pop(click)) {
+            double mx = click.x, my = click.y;
             mouse(mx, my);
         }
         
@@ -378,6 +346,7 @@ int main()
 	}
 
 	// close GL context and any other GLFW resources
+	shaders.destroy();
 	glfwTerminate();
     delete tmap;
 	return 0;
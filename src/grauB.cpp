@@ -14,9 +14,19 @@
 #include <sstream>
 #include <algorithm>
 #include <chrono>
-
-// --- TILE STRUCTURE ---
-struct TileInfo { int tileIndex; bool hasCoin; };
+#include "GLStateCache.h"
+#include "UniformBuffers.h"
+#include "RenderQueue.h"
+#include "IsoTileMap.h"
+#include "IsoGame.h"
+#include "FixedTimestep.h"
+#include "Pathfinding.h"
+#include "InputQueue.h"
+#include "Replay.h"
+#include "Animation.h"
+#include "TextureLoader.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
 
 // --- SCREEN AND TILE CONSTANTS ---
 const int SCREEN_WIDTH = 1280;
@@ -24,420 +34,419 @@ const int SCREEN_HEIGHT = 720;
 const int TILE_WIDTH = 64;
 const int TILE_HEIGHT = 32;
 
-// --- GAME STATE VARIABLES ---
-int playerX = 1, playerY = 1;
-int mapRows = 0, mapCols = 0;
-int coinCount = 0, totalCoins = 0;
-double startTime = 0;
-int coinFrame = 0, playerIdleFrame = 0;
-double coinAnimTimer = 0, playerIdleTimer = 0;
-const double coinAnimSpeed = 0.06, playerIdleSpeed = 0.18;
+// --- GAME STATE ---
+GameState game;
+FixedTimestep timestep(ISO_TICK_RATE);
+
+// --- INPUT ---
+// Key callbacks only queue events; every tick consumes the ones that
+// happened before it and turns them into actions, so taps shorter than a
+// frame still move the player. The session records or replays them
+// (--record ARQ, --replay ARQ [--headless], see Replay.h).
+enum Action { ACTION_UP, ACTION_DOWN, ACTION_LEFT, ACTION_RIGHT, ACTION_RESTART, ACTION_AUTOPILOT, ACTION_TILEMAP };
+ReplaySession session;
+StartupTrace startup;
+InputActions actions;
+int bufferedDx = 0, bufferedDy = 0;   // last tapped direction, kept while the move cooldown runs
+int bufferedTicks = 0;
+
+// --- AUTOPILOT (P) ---
+bool autopilot = false;
+Pathfinder pathfinder;
+std::vector<uint8_t> walkGrid;
+std::vector<int> autopilotPath;
 
 // --- RESOURCE AND OPENGL VARIABLES ---
-std::string tilesetFile;
-std::vector<std::vector<TileInfo>> mapData;
-GLuint shaderProgram, tilesetTexture, vao, vbo;
-GLuint playerTexture, playerIdleTexture;
-GLuint coinTextures[10];
-enum GameState { RUNNING, WON, GAMEOVER };
-GameState gameState = RUNNING;
+GLuint shaderProgram, tilesetTexture;
+GLuint playerTexture;
 glm::mat4 projection;
+FrameUniformBuffer frameUniforms;
+RenderQueue renderQueue;
+IsoTileMap gpuTilemap;
+bool gpuTilemapMode = false;   // T alterna entre quads por tile e o tilemap na GPU
+
+// --- ANIMATION ---
+// Clips from assets/animations/grauB.anim; every coin shares one actor,
+// so they spin in step as before.
+AnimationLibrary animations;
+Animator animator(&animations);
+std::vector<GLuint> sheetTextures;   // indexed by the library's sheet ids
+int coinActor = -1, playerActor = -1;
+
+// --- RENDER QUEUE LAYERS ---
+// Both layers are sorted back to front by row + column. Tiles are drawn as
+// diamonds, like the old triangle fan, and all share one state, so the
+// sorted run of tiles is still a single draw; coins and the player overlap
+// their neighbours and need the order too.
+const unsigned LAYER_TILES   = 0;
+const unsigned LAYER_OBJECTS = 1;
+
+// Depth bits of a sort key: row + column, then column, then coin before
+// player on the same tile. Equal depths would otherwise be ordered by the
+// texture bits, which depend on the order the textures were created in.
+unsigned isoDepth(int diagonal, int column, unsigned onTile = 0) {
+    return ((unsigned)diagonal * (unsigned)game.map.cols + (unsigned)column) * 2 + onTile;
+}
 
 // --- SHADER PROGRAM CREATION ---
 GLuint createShaderProgram() {
     const char* vertexShaderSource = R"(
         #version 330 core
+        )" FRAME_DATA_GLSL R"(
         layout (location = 0) in vec2 aPos;
         layout (location = 1) in vec2 aTexCoord;
-        uniform mat4 model;
-        uniform mat4 projection;
+        layout (location = 2) in vec4 aColor;
         out vec2 TexCoord;
+        out vec4 ColorMod;
         void main() {
-            gl_Position = projection * model * vec4(aPos, 0.0, 1.0);
+            gl_Position = projection * vec4(aPos, 0.0, 1.0);
             TexCoord = aTexCoord;
+            ColorMod = aColor;
         }
     )";
     const char* fragmentShaderSource = R"(
         #version 330 core
         out vec4 FragColor;
         in vec2 TexCoord;
+        in vec4 ColorMod;
         uniform sampler2D tileset;
-        uniform vec4 colorMod;
-        void main() { FragColor = texture(tileset, TexCoord) * colorMod; }
+        void main() { FragColor = texture(tileset, TexCoord) * ColorMod; }
     )";
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    GLuint program = glCreateProgram();
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(vertexShader);
-    glCompileShader(fragmentShader);
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
+    GLuint program = shaderCache.build("grauB", vertexShaderSource, fragmentShaderSource);
+    bindUniformBlocks(program);
     return program;
 }
 
-// --- MAP LOADING FUNCTION ---
-void loadMapFromFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) {
-        std::cerr << "Erro ao abrir " << path << std::endl;
-        return;
-    }
-    std::string line;
-    std::getline(file, tilesetFile);
-    std::getline(file, line);
-    std::istringstream sizeStream(line);
-    sizeStream >> mapRows >> mapCols;
-    mapData.clear();
-    for (int i = 0; i < mapRows; ++i) {
-        std::getline(file, line);
-        std::istringstream rowStream(line);
-        std::vector<TileInfo> row;
-        for (int j = 0; j < mapCols; ++j) {
-            std::string token;
-            rowStream >> token;
-            TileInfo info;
-            if (!token.empty() && token[0] == '/') continue; 
-            if (!token.empty() && token.back() == 'c') {
-                info.hasCoin = true;
-                token.pop_back();
-            } else {
-                info.hasCoin = false;
-            }
-            if (!token.empty()) info.tileIndex = std::stoi(token);
-            else                info.tileIndex = 0;
-            row.push_back(info);
-        }
-        mapData.push_back(row);
-    }
-}
-
 // --- TILESET TEXTURE LOADING ---
+// Textures come from assets/cooked/ when the asset cooker has run (see
+// TextureLoader.h), from the PNGs otherwise.
 void loadTileset(const std::string& path) {
     glGenTextures(1, &tilesetTexture);
-    glBindTexture(GL_TEXTURE_2D, tilesetTexture);
+    glState.bindTexture(0, GL_TEXTURE_2D, tilesetTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);  
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);  
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);    
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);    
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
-    } else {
-        std::cerr << "Erro ao carregar textura\n";
-    }
+    uploadTexture(path);
 }
 
 // --- PLAYER TEXTURE LOADING ---
+// Hard-edged and premultiplied, so it blends without dark fringes.
 void loadPlayerTexture(const std::string& path) {
     glGenTextures(1, &playerTexture);
-    glBindTexture(GL_TEXTURE_2D, playerTexture);
+    glState.bindTexture(0, GL_TEXTURE_2D, playerTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
-    if (data) {
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                int idx = (y * width + x) * 4;
-                if (data[idx + 3] < 128) {
-                    data[idx + 0] = 0;
-                    data[idx + 1] = 0;
-                    data[idx + 2] = 0;
-                    data[idx + 3] = 0;
-                } else {
-                    float alpha = data[idx + 3] / 255.0f;
-                    data[idx + 0] = (unsigned char)(data[idx + 0] * alpha);
-                    data[idx + 1] = (unsigned char)(data[idx + 1] * alpha);
-                    data[idx + 2] = (unsigned char)(data[idx + 2] * alpha);
-                }
-            }
-        }
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
-    } else {
-        std::cerr << "Erro ao carregar textura do personagem\n";
-    }
+    uploadTexture(path, TEXTURE_CUTOUT | TEXTURE_PREMULTIPLY);
 }
 
-// --- COIN ANIMATION TEXTURES LOADING ---
-void loadCoinTextures() {
-    char buf[128];
-    for (int i = 0; i < 10; ++i) {
-        sprintf(buf, "../assets/sprites/Gold_%d.png", i+21);
-        glGenTextures(1, &coinTextures[i]);
-        glBindTexture(GL_TEXTURE_2D, coinTextures[i]);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        int width, height, nrChannels;
-        unsigned char* data = stbi_load(buf, &width, &height, &nrChannels, 4);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        } else {
-            printf("Erro ao carregar %s\n", buf);
-        }
-    }
-}
-
-// --- PLAYER IDLE ANIMATION TEXTURE LOADING ---
-void loadPlayerIdleTexture() {
-    glGenTextures(1, &playerIdleTexture);
-    glBindTexture(GL_TEXTURE_2D, playerIdleTexture);
+// --- ANIMATION SHEET TEXTURE LOADING ---
+GLuint loadSheetTexture(const std::string& path) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glState.bindTexture(0, GL_TEXTURE_2D, texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load("../assets/sprites/Vampires1_Idle_full.png", &width, &height, &nrChannels, 4);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        stbi_image_free(data);
-    } else {
-        printf("Erro ao carregar Vampires1_Idle_full.png\n");
-    }
-}
-
-// --- OPENGL BUFFER INITIALIZATION ---
-void initBuffers() {
-    float vertices[] = {
-        0.0f, 0.0f, 0.0f, 1.0f,
-        0.0f, 1.0f, 0.0f, 0.0f,
-        1.0f, 1.0f, 1.0f, 0.0f,
-        1.0f, 0.0f, 1.0f, 1.0f,
-    };
-    unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    uploadTexture(path);
+    return texture;
 }
 
 // --- TILE DRAWING FUNCTION ---
-void drawTile(int tileIndex, int i, int j, glm::mat4 projection, bool darken = false) {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, tilesetTexture);
-    glUniform1i(glGetUniformLocation(shaderProgram, "tileset"), 0);
-    if (darken) glUniform4f(glGetUniformLocation(shaderProgram, "colorMod"), 0.5f, 0.5f, 0.5f, 1.0f);
-    else        glUniform4f(glGetUniformLocation(shaderProgram, "colorMod"), 1.0f, 1.0f, 1.0f, 1.0f);
+void drawTile(int tileIndex, int i, int j, bool darken = false) {
     float tilesPerRow   = 7.0f;
     float tileU         = (float)tileIndex / tilesPerRow;
     float tileV         = 0.0f;
     float tileUW        = 1.0f / tilesPerRow;
     float tileVH        = 1.0f; 
-    glm::mat4 model     = glm::mat4(1.0f);
     float screenX       = (j - i) * (TILE_WIDTH / 2.0f);
     float screenY       = (i + j) * (TILE_HEIGHT / 2.0f);
-    model               = glm::translate(model, glm::vec3(screenX + SCREEN_WIDTH / 2 - TILE_WIDTH / 2, screenY + SCREEN_HEIGHT / 2 - (mapRows * TILE_HEIGHT) / 2, 0.0f));
-    model               = glm::scale(model, glm::vec3(TILE_WIDTH, TILE_HEIGHT, 1.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    float centerU = tileU + tileUW / 2.0f;
-    float centerV = tileV + tileVH / 2.0f;
-    float vertices[] = {
-        0.5f, 0.5f, centerU,        centerV,
-        0.5f, 0.0f, centerU,        tileV,
-        1.0f, 0.5f, tileU + tileUW, centerV,
-        0.5f, 1.0f, centerU,        tileV + tileVH,
-        0.0f, 0.5f, tileU,          centerV,
-        0.5f, 0.0f, centerU,        tileV
-    };
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 6);
+    SpriteQuad quad;
+    quad.x      = screenX + SCREEN_WIDTH / 2 - TILE_WIDTH / 2;
+    quad.y      = screenY + SCREEN_HEIGHT / 2 - (game.map.rows * TILE_HEIGHT) / 2;
+    quad.w      = TILE_WIDTH;
+    quad.h      = TILE_HEIGHT;
+    quad.u0     = tileU;
+    quad.v0     = tileV;
+    quad.u1     = tileU + tileUW;
+    quad.v1     = tileV + tileVH;
+    quad.color  = darken ? packColor(0.5f, 0.5f, 0.5f) : COLOR_WHITE;
+    quad.diamond = true;
+    uint64_t key = RenderQueue::makeKey(LAYER_TILES, isoDepth(i + j, j), shaderProgram, tilesetTexture, BLEND_ALPHA);
+    renderQueue.submit(key, shaderProgram, tilesetTexture, BLEND_ALPHA, quad);
 }
 
 // --- COIN DRAWING FUNCTION ---
-void drawCoin(int i, int j, glm::mat4 projection) {
+void drawCoin(int i, int j) {
     int winWidth, winHeight;
     glfwGetFramebufferSize(glfwGetCurrentContext(), &winWidth, &winHeight);
-    float mapHeight = (mapRows + mapCols) * (TILE_HEIGHT / 2.0f);
+    float mapHeight = (game.map.rows + game.map.cols) * (TILE_HEIGHT / 2.0f);
     float offsetY   = winHeight / 2 - mapHeight / 2;
-    glUniform4f(glGetUniformLocation(shaderProgram, "colorMod"), 1.0f, 1.0f, 1.0f, 1.0f);
-    glm::mat4 model = glm::mat4(1.0f);
     float screenX   = (j - i) * (TILE_WIDTH / 2.0f);
     float screenY   = (i + j) * (TILE_HEIGHT / 2.0f);
     float px        = screenX + winWidth / 2 - TILE_WIDTH / 2;
     float py        = screenY + offsetY;
     float coinW     = TILE_WIDTH * 0.25f;
     float coinH     = TILE_HEIGHT * 0.35f;
-    model           = glm::translate(model, glm::vec3(px + (TILE_WIDTH - coinW) / 2, py + (TILE_HEIGHT - coinH) / 2, 0.0f));
-    model           = glm::scale(model, glm::vec3(coinW, coinH, 1.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, coinTextures[coinFrame]);
-    glUniform1i(glGetUniformLocation(shaderProgram, "tileset"), 0);
-    float vertices[] = {
-        0.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f,
-    };
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    const UVRect& r = animator.rect(coinActor);
+    SpriteQuad quad = { px + (TILE_WIDTH - coinW) / 2, py + (TILE_HEIGHT - coinH) / 2, coinW, coinH, r.u0, r.v0, r.u1, r.v1, COLOR_WHITE };
+    GLuint texture  = sheetTextures[animator.sheet(coinActor)];
+    uint64_t key    = RenderQueue::makeKey(LAYER_OBJECTS, isoDepth(i + j, j), shaderProgram, texture, BLEND_ALPHA);
+    renderQueue.submit(key, shaderProgram, texture, BLEND_ALPHA, quad);
 }
 
-// --- GAME RESET FUNCTION ---
-void resetGame() {
-    loadMapFromFile("../assets/map.txt");
-    playerX     = (int)std::floor(mapCols / 2.0);
-    playerY     = (int)std::floor(mapRows / 2.0);
-    if (playerY >= 0 && playerY < mapRows && playerX >= 0 && playerX < mapCols) {
-        mapData[playerY][playerX].tileIndex = 6;
-        mapData[playerY][playerX].hasCoin   = false;
+// --- GPU TILEMAP UPLOAD ---
+void uploadTilemap() {
+    const IsoMap& map = game.map;
+    std::vector<uint16_t> ids(map.tiles.size());
+    for (size_t k = 0; k < ids.size(); ++k) ids[k] = (uint16_t)map.tiles[k].tileIndex;
+    gpuTilemap.upload(map.rows, map.cols, ids);
+    glm::vec2 origin(SCREEN_WIDTH / 2 - TILE_WIDTH / 2, SCREEN_HEIGHT / 2 - (map.rows * TILE_HEIGHT) / 2);
+    gpuTilemap.setLayout(origin, glm::vec2(TILE_WIDTH, TILE_HEIGHT), 7);
+}
+
+// --- INPUT FUNCTIONS ---
+void bindActions() {
+    actions.bind(GLFW_KEY_UP, ACTION_UP);
+    actions.bind(GLFW_KEY_DOWN, ACTION_DOWN);
+    actions.bind(GLFW_KEY_LEFT, ACTION_LEFT);
+    actions.bind(GLFW_KEY_RIGHT, ACTION_RIGHT);
+    actions.bind(GLFW_KEY_R, ACTION_RESTART);
+    actions.bind(GLFW_KEY_P, ACTION_AUTOPILOT);
+    actions.bind(GLFW_KEY_T, ACTION_TILEMAP);
+}
+
+GameInput tickInput() {
+    static const int dirs[4][2] = { { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+    for (int a = ACTION_UP; a <= ACTION_RIGHT; ++a) {
+        if (!actions.pressed(a)) continue;
+        bufferedDx    = dirs[a][0];
+        bufferedDy    = dirs[a][1];
+        bufferedTicks = MOVE_COOLDOWN_TICKS;
     }
-    coinCount   = 0;
-    totalCoins  = 0;
-    for (int i = 0; i < mapRows; ++i) for (int j = 0; j < mapCols; ++j) if (mapData[i][j].hasCoin) totalCoins++;
-    gameState = RUNNING;
-    startTime = glfwGetTime();
+    GameInput input;
+    if (actions.held(ACTION_UP))    input.dy--;
+    if (actions.held(ACTION_DOWN))  input.dy++;
+    if (actions.held(ACTION_LEFT))  input.dx--;
+    if (actions.held(ACTION_RIGHT)) input.dx++;
+    if (input.dx == 0 && input.dy == 0 && bufferedTicks > 0) {
+        input.dx = bufferedDx;
+        input.dy = bufferedDy;
+    }
+    input.restart = actions.pressed(ACTION_RESTART) || actions.held(ACTION_RESTART);
+    return input;
 }
 
-// --- INPUT PROCESSING FUNCTION ---
-void processInput(GLFWwindow* window) {
-    static double lastMove  = 0;
-    double now              = glfwGetTime();
-    if (gameState != RUNNING) {
-        if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS) {
-            resetGame();
-            printf("--- Jogo iniciado! ---\n");
-            printf("Colete todas as moedas, sem pisar na lava!\n");
+// --- AUTOPILOT FUNCTIONS ---
+// Plans a path to the coin with the cheapest route, avoiding walls and lava.
+void planAutopilot() {
+    const IsoMap& map = game.map;
+    walkGrid.resize(map.tiles.size());
+    for (size_t k = 0; k < walkGrid.size(); ++k) walkGrid[k] = (uint8_t)map.tiles[k].tileIndex;
+    pathfinder.setGrid(walkGrid.data(), map.cols, map.rows);
+    pathfinder.setCost(TILE_WALL, PATH_BLOCKED);
+    pathfinder.setCost(TILE_LAVA, PATH_BLOCKED);
+    autopilotPath.clear();
+    float best = 0.0f;
+    std::vector<int> path;
+    for (uint32_t cell : map.coins) {
+        int i = cell / map.cols, j = cell % map.cols;
+        if (!pathfinder.findPath(game.playerX, game.playerY, j, i, path)) continue;
+        float cost = pathfinder.lastStats().cost;
+        if (autopilotPath.empty() || cost < best) {
+            best = cost;
+            autopilotPath.swap(path);
         }
-        return;
     }
-    if (now - lastMove < 0.20) return; 
-    int dx = 0, dy = 0;
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)      dy--;
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)    dy++;
-    if (glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS)    dx--;
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)   dx++;
-    int nx      = playerX + dx;
-    int ny      = playerY + dy;
-    int rows    = (int)mapData.size();
-    int cols    = rows > 0 ? (int)mapData[0].size() : 0;
-    if (nx >= 0 && nx < cols && ny >= 0 && ny < rows && (dx != 0 || dy != 0)) {
-        if (mapData[ny][nx].tileIndex == 5) return; 
-        playerX     = nx;
-        playerY     = ny;
-        lastMove    = now;
-        if (mapData[playerY][playerX].hasCoin) {
-            mapData[playerY][playerX].hasCoin = false;
-            coinCount++;
-        }
-        if (coinCount == totalCoins) {
-            gameState = WON;
-            double elapsed = now - startTime;
-            printf("Parabens, voce ganhou o jogo em %.1f segundos!\n", elapsed);
-            printf("Pressione R para reiniciar.\n\n");
-        }
-        if (mapData[playerY][playerX].tileIndex == 3) {
-            gameState = GAMEOVER;
-            printf("Game over, voce pisou na lava!\n");
-            printf("Pressione R para reiniciar.\n\n");
-        }
+}
+
+// Direction of the next step on the planned path, replanning once the
+// path is used up or the player left it.
+GameInput autopilotInput() {
+    GameInput input;
+    int player = game.playerY * game.map.cols + game.playerX;
+    if (autopilotPath.size() >= 2 && autopilotPath[1] == player) autopilotPath.erase(autopilotPath.begin());
+    if (autopilotPath.size() < 2 || autopilotPath[0] != player) planAutopilot();
+    if (autopilotPath.size() < 2) return input;
+    int next = autopilotPath[1];
+    input.dx = next % game.map.cols - game.playerX;
+    input.dy = next / game.map.cols - game.playerY;
+    return input;
+}
+
+// --- GAME EVENT REPORTING ---
+void reportEvents(unsigned events) {
+    if (events & EVENT_RESTART) {
+        uploadTilemap();
+        printf("--- Jogo iniciado! ---\n");
+        printf("Colete todas as moedas, sem pisar na lava!\n");
+    }
+    if (events & EVENT_WON) {
+        printf("Parabens, voce ganhou o jogo em %.1f segundos!\n", roundSeconds(game));
+        printf("Pressione R para reiniciar.\n\n");
     }
+    if (events & EVENT_LAVA) {
+        printf("Game over, voce pisou na lava!\n");
+        printf("Pressione R para reiniciar.\n\n");
+    }
+}
+
+// --- KEY CALLBACK ---
+void keyCallback(GLFWwindow*, int key, int, int action, int mods) {
+    session.push(InputEvent::key(glfwGetTime(), key, action, mods));
 }
 
 // --- PLAYER DRAWING FUNCTION ---
-void drawPlayer(int i, int j, glm::mat4 projection) {
+// Takes fractional tile coordinates so the player can be drawn between ticks.
+void drawPlayer(float i, float j) {
     int winWidth, winHeight;
     glfwGetFramebufferSize(glfwGetCurrentContext(), &winWidth, &winHeight);
-    float mapHeight = (mapRows + mapCols) * (TILE_HEIGHT / 2.0f);
+    float mapHeight = (game.map.rows + game.map.cols) * (TILE_HEIGHT / 2.0f);
     float offsetY   = winHeight / 2 - mapHeight / 2;
-    glUniform4f(glGetUniformLocation(shaderProgram, "colorMod"), 1.0f, 1.0f, 1.0f, 1.0f);
     float screenX   = (j - i) * (TILE_WIDTH / 2.0f);
     float screenY   = (i + j) * (TILE_HEIGHT / 2.0f);
     float px        = screenX + winWidth / 2 - TILE_WIDTH / 2;
     float py        = screenY + offsetY;
     float spriteW   = TILE_WIDTH * 0.7f; 
     float spriteH   = TILE_HEIGHT * 1.2f; 
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(px + (TILE_WIDTH - spriteW) / 2, py + (TILE_HEIGHT - spriteH) - TILE_HEIGHT / 4, 0.0f));
-    model = glm::scale(model, glm::vec3(spriteW, spriteH, 1.0f));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    float fw = 1.0f / 4.0f, fh = 1.0f; 
-    float u0 = playerIdleFrame * fw;
-    float v0 = 0.0f;
-    float u1 = u0 + fw;
-    float v1 = v0 + fh;
-    float vertices[] = {
-        0.0f, 0.0f, u0, v0,
-        0.0f, 1.0f, u0, v1,
-        1.0f, 1.0f, u1, v1,
-        1.0f, 0.0f, u1, v0,
-    };
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-    glBindVertexArray(vao);
-    glBindTexture(GL_TEXTURE_2D, playerIdleTexture);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    const UVRect& r = animator.rect(playerActor);
+    SpriteQuad quad = { px + (TILE_WIDTH - spriteW) / 2, py + (TILE_HEIGHT - spriteH) - TILE_HEIGHT / 4, spriteW, spriteH, r.u0, r.v0, r.u1, r.v1, COLOR_WHITE };
+    GLuint texture  = sheetTextures[animator.sheet(playerActor)];
+    unsigned depth  = isoDepth((int)std::ceil(i + j), (int)std::ceil(j), 1);
+    uint64_t key    = RenderQueue::makeKey(LAYER_OBJECTS, depth, shaderProgram, texture, BLEND_ALPHA);
+    renderQueue.submit(key, shaderProgram, texture, BLEND_ALPHA, quad);
 }
 
 // --- MAIN GAME LOOP ---
-int main() {
+// The level text is the replay payload, so a recording replays the map it
+// was played on even if assets/map.txt changed since.
+int main(int argc, char** argv) {
+    if (!session.parseArgs(argc, argv)) return 1;
+    startup.parseArgs(argc, argv);
+    std::ifstream mapFile("../assets/map.txt");
+    std::stringstream mapText;
+    mapText << mapFile.rdbuf();
+    uint32_t seed = 0;
+    std::string level = mapText.str();
+    session.start(seed, level);
+    bindActions();
+    startup.phase("scene");
     glfwInit();
+    startup.phase("glfwInit");
+    if (session.headless() || startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tilemap Isometrico", NULL, NULL);
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    startup.phase("glad");
+    if (session.replaying() || startup.headless()) glfwSwapInterval(0);
+    glState.setBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     shaderProgram = createShaderProgram();
-    glUseProgram(shaderProgram);
-    resetGame();
+    glState.useProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "tileset"), 0);
+    startup.phase("shaders");
+    frameUniforms.init();
+    renderQueue.init();
+    gpuTilemap.init();
+    glfwSetKeyCallback(window, keyCallback);
+    std::istringstream levelStream(level);
+    if (!loadIsoMap(levelStream, game.level)) printf("Erro ao ler o mapa\n");
+    resetGame(game);
+    uploadTilemap();
     printf("--- Jogo iniciado! ---\n");
     printf("Colete todas as moedas, sem pisar na lava!\n");
-    loadTileset(std::string("../assets/tilesets/") + tilesetFile);
+    startup.phase("scene");
+    loadTileset(std::string("../assets/tilesets/") + game.level.tileset);
     loadPlayerTexture("../assets/sprites/Vampirinho.png");
-    loadCoinTextures();
-    loadPlayerIdleTexture();
-    initBuffers();
+    if (!animations.load(std::string("../assets/animations/grauB.anim"))) return 1;
+    for (const AnimSheet& sheet : animations.getSheets()) sheetTextures.push_back(loadSheetTexture(sheet.path));
+    startup.phase("textures");
+    int coinClip = animations.clipId("coin"), idleClip = animations.clipId("player_idle");
+    if (coinClip < 0 || idleClip < 0) {
+        printf("grauB.anim precisa dos clipes coin e player_idle\n");
+        return 1;
+    }
+    coinActor   = animator.add(coinClip);
+    playerActor = animator.add(idleClip);
     projection = glm::ortho(0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT, 0.0f);
+    startup.phase("scene");
     double lastTime = glfwGetTime();
-    while (!glfwWindowShouldClose(window)) {
-        double now      = glfwGetTime();
-        double delta    = now - lastTime;
-        lastTime        = now;
-        coinAnimTimer += delta;
-        if (coinAnimTimer > coinAnimSpeed) {
-            coinAnimTimer   = 0;
-            coinFrame       = (coinFrame + 1) % 10;
-        }
-        playerIdleTimer += delta;
-        if (playerIdleTimer > playerIdleSpeed) {
-            playerIdleTimer = 0;
-            playerIdleFrame = (playerIdleFrame + 1) % 4;
+    double simTime = 0;
+    double statsTimer = 0;
+    while (!glfwWindowShouldClose(window) && !session.done()) {
+        double now       = glfwGetTime();
+        double wallDelta = now - lastTime;
+        double delta     = session.frameDelta(wallDelta, timestep.step());
+        lastTime         = now;
+        simTime         += delta;
+        timestep.accumulate(delta);
+        while (timestep.tick()) {
+            session.consume(game.tick, now - timestep.lag(), [](const InputEvent& e) { actions.apply(e); });
+            if (actions.pressed(ACTION_TILEMAP)) {
+                gpuTilemapMode = !gpuTilemapMode;
+                printf("Tilemap: %s\n", gpuTilemapMode ? "shader na GPU" : "quads por tile");
+            }
+            if (actions.pressed(ACTION_AUTOPILOT)) {
+                autopilot = !autopilot;
+                autopilotPath.clear();
+                printf("Piloto automatico: %s\n", autopilot ? "ligado" : "desligado");
+            }
+            GameInput input = tickInput();
+            if (autopilot && game.status == RUNNING && input.dx == 0 && input.dy == 0) {
+                GameInput planned = autopilotInput();
+                input.dx = planned.dx;
+                input.dy = planned.dy;
+            }
+            unsigned events = step(game, input);
+            animator.update((float)timestep.step());
+            if (events & EVENT_MOVED) bufferedTicks = 0;
+            else if (bufferedTicks > 0) bufferedTicks--;
+            actions.endTick();
+            reportEvents(events);
         }
-        processInput(window);
+        float alpha = timestep.alpha();
         glClear(GL_COLOR_BUFFER_BIT);
-        glBindTexture(GL_TEXTURE_2D, tilesetTexture);
-        for (int i = 0; i < mapRows; ++i) for (int j = 0; j < mapCols; ++j) {
-            bool darken = (playerY == i && playerX == j);
-            drawTile(mapData[i][j].tileIndex, i, j, projection, darken);
-            if (mapData[i][j].hasCoin) drawCoin(i, j, projection);
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        frameUniforms.update(projection, (float)simTime, fbWidth, fbHeight);
+        if (gpuTilemapMode) {
+            gpuTilemap.setHighlight(game.playerY, game.playerX);
+            gpuTilemap.draw(tilesetTexture);
+        }
+        if (!gpuTilemapMode) {
+            for (int i = 0; i < game.map.rows; ++i) for (int j = 0; j < game.map.cols; ++j) {
+                bool darken = (game.playerY == i && game.playerX == j);
+                drawTile(game.map.at(i, j).tileIndex, i, j, darken);
+            }
+        }
+        // the render queue sorts coins by depth, so the index order does not matter
+        for (uint32_t cell : game.map.coins) drawCoin(cell / game.map.cols, cell % game.map.cols);
+        float playerI = game.prevPlayerY + (game.playerY - game.prevPlayerY) * alpha;
+        float playerJ = game.prevPlayerX + (game.playerX - game.prevPlayerX) * alpha;
+        drawPlayer(playerI, playerJ);
+        renderQueue.flush();
+        QueueStats queueStats = renderQueue.endFrame();
+        GLStateStats stats = glState.endFrame();
+        statsTimer += wallDelta;
+        if (statsTimer > 0.5 && wallDelta > 0.0) {
+            char title[192];
+            sprintf(title, "Tilemap Isometrico | FPS %.1f | %u comandos em %u draws | estado GL: %u emitidas, %u filtradas",
+                    1.0 / wallDelta, queueStats.commands, queueStats.draws, stats.issued, stats.filtered);
+            glfwSetWindowTitle(window, title);
+            statsTimer = 0;
         }
-        drawPlayer(playerY, playerX, projection);
         glfwSwapBuffers(window);
+        session.endFrame();
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
         glfwPollEvents();
     }
+    session.finish("grauB");
     printf("------------------------------------------\n");
+    renderQueue.destroy();
+    frameUniforms.destroy();
     glfwTerminate();
     return 0;
-}
\ No newline at end of file
+}
@@ -1,56 +1,85 @@
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <cstddef>
 #include <ctime>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "GpuArena.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
 using namespace std;
 using namespace glm;
 
 const GLint WIDTH = 800, HEIGHT = 600;
 GLuint shaderID;
-GLuint colorLoc;
 GLuint projectionLoc;
 mat4 projection;
-struct Triangle { vec2 position; vec4 color; };
-std::vector<Triangle> triangles;
-std::vector<GLuint> staticVAOs;
-GLuint baseVAO;
+// Every triangle, fixed or clicked, is three coloured vertices appended to
+// one arena and drawn with a single glDrawArrays.
+struct Vertex { vec3 position; vec4 color; };
+GpuArena triangleArena;
+GLuint triangleVAO;
+unsigned arenaGeneration = 0;   // arena generation the VAO points at
+GLsizei vertexCount = 0;
+// Shape stamped at each click, relative to the cursor.
+const vec2 clickShape[3] = {
+    vec2(-0.1f * WIDTH, -0.1f * HEIGHT), vec2(0.1f * WIDTH, -0.1f * HEIGHT), vec2(0.0f, 0.1f * HEIGHT)
+};
 
 const char* vertex_shader = R"(
     #version 330 core
     layout (location = 0) in vec3 aPos;
+    layout (location = 1) in vec4 aColor;
     uniform mat4 projection;
-    uniform mat4 model;
-    void main() { gl_Position = projection * model * vec4(aPos, 1.0); }
+    out vec4 vColor;
+    void main() {
+        vColor = aColor;
+        gl_Position = projection * vec4(aPos, 1.0);
+    }
 )";
 
 const char* fragment_shader = R"(
     #version 330 core
+    in vec4 vColor;
     out vec4 FragColor;
-    uniform vec4 color;
-    void main() { FragColor = color; }
+    void main() { FragColor = vColor; }
 )";
 
-GLuint createTriangle(float x0, float y0, float x1, float y1, float x2, float y2) {
-    float vertices[] = {
-        x0, y0, 0.0f,
-        x1, y1, 0.0f,
-        x2, y2, 0.0f
+void addTriangle(vec2 a, vec2 b, vec2 c, vec4 color) {
+    Vertex vertices[3] = {
+        { vec3(a, 0.0f), color },
+        { vec3(b, 0.0f), color },
+        { vec3(c, 0.0f), color }
     };
-    GLuint VAO, VBO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    triangleArena.append(vertices, sizeof(vertices));
+    vertexCount += 3;
+}
+
+// Re-points the VAO at the arena; needed again whenever the arena grew.
+void pointVertexArray() {
+    glState.bindVertexArray(triangleVAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, triangleArena.id());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
     glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-    return VAO;
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    glEnableVertexAttribArray(1);
+    arenaGeneration = triangleArena.getGeneration();
+}
+
+vec4 randomColor() {
+    float r = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
+    float g = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
+    float b = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
+    return vec4(r, g, b, 1.0f);
+}
+
+void stampTriangle(vec2 position, vec4 color) {
+    addTriangle(position + clickShape[0], position + clickShape[1], position + clickShape[2], color);
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
@@ -59,19 +88,17 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
         glfwGetCursorPos(window, &xpos, &ypos);
         float x = static_cast<float>(xpos);
         float y = static_cast<float>(HEIGHT - ypos);
-        float r = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
-        float g = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
-        float b = 0.2f + static_cast<float>(rand()) / RAND_MAX * 0.8f;
-        Triangle t;
-        t.position = vec2(x, y);
-        t.color = vec4(r, g, b, 1.0f);
-        triangles.push_back(t);
+        stampTriangle(vec2(x, y), randomColor());
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    StartupTrace startup;
+    startup.parseArgs(argc, argv);
     srand(static_cast<unsigned int>(time(0)));
     glfwInit();
+    startup.phase("glfwInit");
+    if (startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -82,53 +109,46 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    startup.phase("glad");
+    if (startup.headless()) glfwSwapInterval(0);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glViewport(0, 0, WIDTH, HEIGHT);
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(vertexShader, 1, &vertex_shader, NULL);
-    glCompileShader(vertexShader);
-    glShaderSource(fragmentShader, 1, &fragment_shader, NULL);
-    glCompileShader(fragmentShader);
-    shaderID = glCreateProgram();
-    glAttachShader(shaderID, vertexShader);
-    glAttachShader(shaderID, fragmentShader);
-    glLinkProgram(shaderID);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    shaderID = shaderCache.build("tarefa02", vertex_shader, fragment_shader);
     glUseProgram(shaderID);
-    colorLoc = glGetUniformLocation(shaderID, "color");
     projectionLoc = glGetUniformLocation(shaderID, "projection");
     projection = ortho(0.0f, static_cast<float>(WIDTH), 0.0f, static_cast<float>(HEIGHT));
     glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, value_ptr(projection));
-    staticVAOs.push_back(createTriangle(100, 100, 150, 100, 125, 150));
-    staticVAOs.push_back(createTriangle(300, 200, 350, 200, 325, 250));
-    staticVAOs.push_back(createTriangle(500, 400, 550, 400, 525, 450));
-    staticVAOs.push_back(createTriangle(700, 100, 750, 100, 725, 150));
-    staticVAOs.push_back(createTriangle(900, 300, 950, 300, 925, 350));
-    baseVAO = createTriangle(-0.1f * WIDTH, -0.1f * HEIGHT, 0.1f * WIDTH, -0.1f * HEIGHT, 0.0f, 0.1f * HEIGHT);
+    startup.phase("shaders");
+    glGenVertexArrays(1, &triangleVAO);
+    triangleArena.init(256 * 3 * sizeof(Vertex));
+    const vec4 fixedColor(0.8f, 0.3f, 0.2f, 1.0f);
+    addTriangle(vec2(100, 100), vec2(150, 100), vec2(125, 150), fixedColor);
+    addTriangle(vec2(300, 200), vec2(350, 200), vec2(325, 250), fixedColor);
+    addTriangle(vec2(500, 400), vec2(550, 400), vec2(525, 450), fixedColor);
+    addTriangle(vec2(700, 100), vec2(750, 100), vec2(725, 150), fixedColor);
+    addTriangle(vec2(900, 300), vec2(950, 300), vec2(925, 350), fixedColor);
+    // stress test: `tarefa02 <n>` stamps n triangles at random positions
+    int stress = argc > 1 ? atoi(argv[1]) : 0;
+    for (int i = 0; i < stress; ++i) stampTriangle(vec2(rand() % WIDTH, rand() % HEIGHT), randomColor());
+    if (stress > 0) {
+        printf("%d triângulos | arena de %.1f MB após %u crescimentos\n", stress,
+               triangleArena.getCapacity() / (1024.0 * 1024.0), triangleArena.growCount());
+    }
+    startup.phase("scene");
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
         glUseProgram(shaderID);
-        for (GLuint vao : staticVAOs) {
-            glBindVertexArray(vao);
-            glUniform4f(colorLoc, 0.8f, 0.3f, 0.2f, 1.0f);
-            glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(mat4(1.0f)));
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-        }
-        for (const Triangle& t : triangles) {
-            mat4 model = translate(mat4(1.0f), vec3(t.position, 0.0f));
-            glBindVertexArray(baseVAO);
-            glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-            glUniform4f(colorLoc, t.color.r, t.color.g, t.color.b, t.color.a);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-        }
-        glBindVertexArray(0);
+        if (triangleArena.getGeneration() != arenaGeneration) pointVertexArray();
+        glState.bindVertexArray(triangleVAO);
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
         glfwSwapBuffers(window);
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
+    triangleArena.release();
     glfwTerminate();
     return EXIT_SUCCESS;
 }
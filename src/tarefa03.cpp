@@ -3,7 +3,11 @@
 #include <assert.h>
 #include <vector>
 #include <ctime>
+#include <cstdlib>
+#include <algorithm>
 #include <cmath>
+#include <random>
+#include <sstream>
 using namespace std;
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -12,72 +16,136 @@ using namespace std;
 #include <glm/gtc/type_ptr.hpp>
 using namespace glm;
 #include <cmath>
+#include "ColorIndex.h"
+#include "FixedTimestep.h"
+#include "InputQueue.h"
+#include "Replay.h"
+#include "SparseSet.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 GLuint createQuad();
+void uploadGrid();
+void uploadDirtyCells();
 int setupShader();
 int setupGeometry();
 void whipeQuads(vec3 color);
+void clickCell(double xpos, double ypos);
 void resetGame();
 const GLuint WIDTH = 800, HEIGHT = 600;
-const GLuint QUAD_WIDTH = 100, QUAD_HEIGHT = 100;
-const GLuint COLS = WIDTH / QUAD_WIDTH;
-const GLuint ROWS = HEIGHT / QUAD_HEIGHT;
+const int MAX_GRID_SIDE = 4096;
+const float WHIPE_RADIUS = 0.5f;
+// Grid size comes from the command line (`tarefa03 [linhas colunas]`);
+// the default 6x8 grid fills the window with 100x100 quads.
+int rows = 6, cols = 8;
+float quadWidth, quadHeight;
 int points = 100;
 int attempts = 0;
 bool gameOver = false;
 vec3 selectedColor;
+mt19937 rng;
 
+// Clicks and R are queued by the callbacks and handled per 60 Hz tick, so a
+// game can be recorded and replayed (--record ARQ, --replay ARQ [--headless]);
+// the recording keeps the seed and the grid size.
+ReplaySession session;
+StartupTrace startup;
+FixedTimestep timestep(60.0);
+uint64_t tickCount = 0;
+
+// The whole grid is one instanced draw: instance k is cell k (row-major),
+// its rectangle comes from gl_InstanceID and its colour and alive flag
+// from two per-instance buffers. Whiped cells are moved outside the clip
+// volume by the vertex shader, so they cost no fragments.
 const GLchar *vertexShaderSource = R"(
     #version 400
     layout (location = 0) in vec3 position;
+    layout (location = 1) in vec4 cellColor;
+    layout (location = 2) in float alive;
     uniform mat4 projection;
-    uniform mat4 model;
-    void main()	{ gl_Position = projection * model * vec4(position.x, position.y, position.z, 1.0); }
+    uniform vec2 cellSize;
+    uniform int cols;
+    out vec4 vColor;
+    void main() {
+        vColor = cellColor;
+        if (alive < 0.5) { gl_Position = vec4(2.0, 2.0, 2.0, 1.0); return; }
+        vec2 center = (vec2(gl_InstanceID % cols, gl_InstanceID / cols) + 0.5) * cellSize;
+        gl_Position = projection * vec4(center + position.xy * cellSize, 0.0, 1.0);
+    }
 )";
 
 const GLchar *fragmentShaderSource = R"(
     #version 400
-    uniform vec4 inputColor;
+    in vec4 vColor;
     out vec4 color;
-    void main() { color = inputColor; }
+    void main() { color = vColor; }
 )";
 
+// Neighbouring dirty cells closer than this are uploaded as one range.
+const int DIRTY_MERGE_GAP = 256;
+
 struct Quad {
-	vec3 position;
-	vec3 dimensions;
 	vec3 color;
-	bool whiped;
 };
-Quad grid[ROWS][COLS];
+vector<Quad> grid;      // row-major, cell i * cols + j
+SparseSet alive;        // cells not whiped yet; the game ends when it is empty
+ColorIndex colorIndex;  // colours of the live cells, for the whipe query
+GLuint colorVBO, aliveVBO;      // per-instance RGBA8 colour and alive byte
+vector<uint8_t> aliveFlags;     // CPU copy of aliveVBO
+vector<uint32_t> dirtyCells;    // cells whose alive byte changed since the last upload
 
 void resetGame() {
-	for (int i = 0; i < ROWS; i++) {
-		for (int j = 0; j < COLS; j++) {
+	grid.resize(rows * cols);
+	alive.init(rows * cols);
+	vector<float> colors(rows * cols * 3);
+	for (int i = 0; i < rows; i++) {
+		for (int j = 0; j < cols; j++) {
 			Quad quad;
-			vec2 ini_pos = vec2(QUAD_WIDTH / 2, QUAD_HEIGHT / 2);
-			quad.position = vec3(ini_pos.x + j * QUAD_WIDTH, ini_pos.y + i * QUAD_HEIGHT, 0.0);
-			quad.dimensions = vec3(QUAD_WIDTH, QUAD_HEIGHT, 1.0);
-			quad.color = vec3(rand() % 256 / 255.0, rand() % 256 / 255.0, rand() % 256 / 255.0);
-			quad.whiped = false;
-			grid[i][j] = quad;
+			quad.color = vec3(rng() % 256 / 255.0, rng() % 256 / 255.0, rng() % 256 / 255.0);
+			int cell = i * cols + j;
+			grid[cell] = quad;
+			alive.insert(cell);
+			colors[cell * 3] = quad.color.r;
+			colors[cell * 3 + 1] = quad.color.g;
+			colors[cell * 3 + 2] = quad.color.b;
 		}
 	}
+	colorIndex.build(colors.data(), rows * cols);
+	uploadGrid();
 	points = 100;
 	attempts = 0;
 	gameOver = false;
 	cout << "Jogo reiniciado! Pontuação: " << points << endl;
 }
 
-int main() {
-	srand(time(NULL));
+int main(int argc, char **argv) {
+	if (!session.parseArgs(argc, argv)) return 1;
+	startup.parseArgs(argc, argv);
+	if (argc > 2 && argv[1][0] != '-') {
+		rows = std::max(1, std::min(MAX_GRID_SIDE, atoi(argv[1])));
+		cols = std::max(1, std::min(MAX_GRID_SIDE, atoi(argv[2])));
+	}
+	uint32_t seed = (uint32_t)time(NULL);
+	string gridSize = to_string(rows) + " " + to_string(cols);
+	session.start(seed, gridSize);
+	istringstream(gridSize) >> rows >> cols;
+	rng.seed(seed);
+	quadWidth = (float)WIDTH / cols;
+	quadHeight = (float)HEIGHT / rows;
+	startup.phase("scene");
 	glfwInit();
+	startup.phase("glfwInit");
+	if (session.headless() || startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 	GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Jogo das Cores", nullptr, nullptr);
 	glfwMakeContextCurrent(window);
 	glfwSetKeyCallback(window, key_callback);
 	glfwSetMouseButtonCallback(window, mouse_button_callback);
+	startup.phase("window");
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { std::cout << "Failed to initialize GLAD" << std::endl; }
+	startup.phase("glad");
+	if (session.replaying() || startup.headless()) glfwSwapInterval(0);
 	const GLubyte *renderer = glGetString(GL_RENDERER);
 	const GLubyte *version = glGetString(GL_VERSION);
 	cout << "Renderer: " << renderer << endl;
@@ -85,95 +153,90 @@ int main() {
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
+	startup.phase("scene");
 	GLuint shaderID = setupShader();
+	startup.phase("shaders");
 	GLuint quadVAO = createQuad();
 	glUseProgram(shaderID);
-	GLint colorLoc = glGetUniformLocation(shaderID, "inputColor");
 	mat4 projection = ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
 	glUniformMatrix4fv(glGetUniformLocation(shaderID, "projection"), 1, GL_FALSE, value_ptr(projection));
+	glUniform2f(glGetUniformLocation(shaderID, "cellSize"), quadWidth, quadHeight);
+	glUniform1i(glGetUniformLocation(shaderID, "cols"), cols);
 	cout << "Jogo iniciado! Pontuação: " << points << endl;
 	resetGame();
 	cout << "Clique em um quadrado para escolher a cor. Pressione R para reiniciar." << endl;
-	while (!glfwWindowShouldClose(window)) {
+	startup.phase("scene");
+	double lastTime = glfwGetTime();
+	while (!glfwWindowShouldClose(window) && !session.done()) {
 		glfwPollEvents();
+		double now = glfwGetTime();
+		timestep.accumulate(session.frameDelta(now - lastTime, timestep.step()));
+		lastTime = now;
+		while (timestep.tick()) {
+			session.consume(tickCount++, now - timestep.lag(), [](const InputEvent &e) {
+				if (e.action != INPUT_PRESS) return;
+				if (e.type == INPUT_KEY && e.code == GLFW_KEY_R) resetGame();
+				else if (e.type == INPUT_MOUSE_BUTTON && e.code == GLFW_MOUSE_BUTTON_LEFT) clickCell(e.x, e.y);
+			});
+		}
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT);
 		glLineWidth(10);
 		glPointSize(20);
 		glBindVertexArray(quadVAO);
-		for (int i = 0; i < ROWS; i++) {
-			for (int j = 0; j < COLS; j++) {
-				if (!grid[i][j].whiped) {
-					mat4 model = mat4(1);
-					model = translate(model, grid[i][j].position);
-					model = scale(model, grid[i][j].dimensions);
-					glUniformMatrix4fv(glGetUniformLocation(shaderID, "model"), 1, GL_FALSE, value_ptr(model));
-					glUniform4f(
-                        colorLoc,
-                        grid[i][j].color.r,
-                        grid[i][j].color.g,
-                        grid[i][j].color.b,
-                        1.0f
-                    );
-				}
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			}
-		}
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, rows * cols);
 		glBindVertexArray(0);
-		if (!gameOver) {
-			bool allWhiped = true;
-			for (int i = 0; i < ROWS; i++)
-				for (int j = 0; j < COLS; j++)
-					if (!grid[i][j].whiped) { allWhiped = false; }
-			if (allWhiped) {
-				gameOver = true;
-				cout << "\nFIM DE JOGO! Pontuação final: " << points << ", tentativas: " << attempts << endl;
-				cout << "Pressione R para reiniciar." << endl;
-			}
-		}
 		glfwSwapBuffers(window);
+		session.endFrame();
+		if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
 	}
+	session.finish("tarefa03");
 	glfwTerminate();
 	return 0;
 }
 
 void whipeQuads(vec3 color) {
 	if (gameOver) return;
-	int count = 0;
-	for (int i = 0; i < ROWS; i++) {
-		for (int j = 0; j < COLS; j++) {
-			if (!grid[i][j].whiped) {
-				double d = sqrt(pow(color.r - grid[i][j].color.r, 2) +
-							pow(color.g - grid[i][j].color.g, 2) +
-							pow(color.b - grid[i][j].color.b, 2));
-				if (d <= 0.5) {
-					count++;
-					grid[i][j].whiped = true;
-				}
-			}
-		}
+	static vector<uint32_t> whiped;
+	whiped.clear();
+	int count = (int)colorIndex.extractWithin(color.r, color.g, color.b, WHIPE_RADIUS, whiped);
+	for (uint32_t cell : whiped) {
+		alive.erase(cell);
+		aliveFlags[cell] = 0;
+		dirtyCells.push_back(cell);
 	}
+	uploadDirtyCells();
 	if (count > 0) { points += count * 5; } 
     else { points -= 10; }
 	attempts++;
 	cout << "Pontuação: " << points << " | Tentativas: " << attempts << endl;
+	if (alive.empty()) {
+		gameOver = true;
+		cout << "\nFIM DE JOGO! Pontuação final: " << points << ", tentativas: " << attempts << endl;
+		cout << "Pressione R para reiniciar." << endl;
+	}
 }
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode) {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) { glfwSetWindowShouldClose(window, GL_TRUE); }
-	if (key == GLFW_KEY_R && action == GLFW_PRESS) { resetGame(); }
+	if (key == GLFW_KEY_R) { session.push(InputEvent::key(glfwGetTime(), key, action, mode)); }
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
-	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && !gameOver) {
+	if (button == GLFW_MOUSE_BUTTON_LEFT) {
 		double xpos, ypos;
 		glfwGetCursorPos(window, &xpos, &ypos);
-		int col = (int)(xpos / QUAD_WIDTH);
-		int row = (int)(ypos / QUAD_HEIGHT);
-		if (row >= 0 && row < ROWS && col >= 0 && col < COLS && !grid[row][col].whiped) {
-			selectedColor = grid[row][col].color;
-			whipeQuads(selectedColor);
-		}
+		session.push(InputEvent::mouseButton(glfwGetTime(), button, action, mods, xpos, ypos));
+	}
+}
+
+void clickCell(double xpos, double ypos) {
+	if (gameOver) return;
+	int col = (int)(xpos / quadWidth);
+	int row = (int)(ypos / quadHeight);
+	if (row >= 0 && row < rows && col >= 0 && col < cols && alive.contains(row * cols + col)) {
+		selectedColor = grid[row * cols + col].color;
+		whipeQuads(selectedColor);
 	}
 }
 
@@ -193,43 +256,56 @@ GLuint createQuad() {
 	glBindVertexArray(VAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
 	glEnableVertexAttribArray(0);
+	// per-instance colour (normalized RGBA8) and alive flag (normalized byte)
+	glGenBuffers(1, &colorVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4, (GLvoid *)0);
+	glVertexAttribDivisor(1, 1);
+	glEnableVertexAttribArray(1);
+	glGenBuffers(1, &aliveVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, aliveVBO);
+	glVertexAttribPointer(2, 1, GL_UNSIGNED_BYTE, GL_TRUE, 1, (GLvoid *)0);
+	glVertexAttribDivisor(2, 1);
+	glEnableVertexAttribArray(2);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	return VAO;
 }
 
-int setupShader() {
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
+// Uploads every cell's colour and alive flag; called when the grid is rebuilt.
+void uploadGrid() {
+	vector<uint8_t> rgba(grid.size() * 4);
+	for (size_t cell = 0; cell < grid.size(); cell++) {
+		rgba[cell * 4] = (uint8_t)std::lround(grid[cell].color.r * 255.0f);
+		rgba[cell * 4 + 1] = (uint8_t)std::lround(grid[cell].color.g * 255.0f);
+		rgba[cell * 4 + 2] = (uint8_t)std::lround(grid[cell].color.b * 255.0f);
+		rgba[cell * 4 + 3] = 255;
 	}
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-				  << infoLog << std::endl;
+	aliveFlags.assign(grid.size(), 255);
+	dirtyCells.clear();
+	glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+	glBufferData(GL_ARRAY_BUFFER, rgba.size(), rgba.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, aliveVBO);
+	glBufferData(GL_ARRAY_BUFFER, aliveFlags.size(), aliveFlags.data(), GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Uploads the alive bytes of the cells changed by a click, merging nearby
+// cells into one glBufferSubData so a click costs O(cells whiped).
+void uploadDirtyCells() {
+	if (dirtyCells.empty()) return;
+	sort(dirtyCells.begin(), dirtyCells.end());
+	glBindBuffer(GL_ARRAY_BUFFER, aliveVBO);
+	size_t k = 0;
+	while (k < dirtyCells.size()) {
+		uint32_t first = dirtyCells[k], last = first;
+		while (++k < dirtyCells.size() && dirtyCells[k] - last <= DIRTY_MERGE_GAP) last = dirtyCells[k];
+		glBufferSubData(GL_ARRAY_BUFFER, first, last - first + 1, &aliveFlags[first]);
 	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	return shaderProgram;
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	dirtyCells.clear();
+}
+
+int setupShader() {
+	return shaderCache.build("tarefa03", vertexShaderSource, fragmentShaderSource);
 }
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include <string>
 #include <vector>
 #include <assert.h>
+#include <cctype>
 #include <cmath>
+#include <cstdlib>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -10,133 +12,97 @@
 #include <GLFW/glfw3.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include "GLStateCache.h"
+#include "UniformBuffers.h"
+#include "SpriteBatch.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
+#include "TextureLoader.h"
 using namespace std;
 const GLuint WIDTH = 800, HEIGHT = 600;
 
 const GLchar* vertexShaderSource = R"(
     #version 400
-    layout (location = 0) in vec3 position;
+    )" FRAME_DATA_GLSL R"(
+    layout (location = 0) in vec2 position;
     layout (location = 1) in vec2 texCoord;
-    uniform mat4 model;
-    uniform mat4 projection;
+    layout (location = 2) in vec4 colorMod;
     out vec2 TexCoord;
+    out vec4 ColorMod;
     void main() {
         TexCoord = texCoord;
-        gl_Position = projection * model * vec4(position, 1.0);
+        ColorMod = colorMod;
+        gl_Position = projection * vec4(position, 0.0, 1.0);
     }
 )";
 
 const GLchar* fragmentShaderSource = R"(
     #version 400
     in vec2 TexCoord;
+    in vec4 ColorMod;
     out vec4 color;
     uniform sampler2D tex;
-    void main() { color = texture(tex, TexCoord); }
+    void main() { color = texture(tex, TexCoord) * ColorMod; }
 )";
 
 glm::mat4 projection = glm::ortho(0.0f, float(WIDTH), 0.0f, float(HEIGHT), -1.0f, 1.0f);
+FrameUniformBuffer frameUniforms;
+SpriteBatch spriteBatch;
 class Sprite {
 public:
-    GLuint VAO;
     GLuint textureID;
     GLuint shaderProgram;
     glm::vec2 position, scale;
     float rotation;
+    glm::vec2 velocity = glm::vec2(0.0f);
+    float spin = 0.0f;
     Sprite(GLuint shader, GLuint texID, glm::vec2 pos, glm::vec2 scl, float rot)
-        : shaderProgram(shader), textureID(texID), position(pos), scale(scl), rotation(rot) {
-        setupVAO();
+        : shaderProgram(shader), textureID(texID), position(pos), scale(scl), rotation(rot) {}
+    void update(float dt) {
+        position += velocity * dt;
+        rotation += spin * dt;
+        // quica nas bordas da janela
+        if (position.x < 0.0f || position.x > WIDTH)  velocity.x = -velocity.x;
+        if (position.y < 0.0f || position.y > HEIGHT) velocity.y = -velocity.y;
     }
     void draw() {
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f));
-        model = glm::rotate(model, glm::radians(rotation), glm::vec3(0, 0, 1));
-        model = glm::scale(model, glm::vec3(scale, 1.0f));
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-        glBindVertexArray(0);
-    }
-private:
-    void setupVAO() {
-        GLfloat vertices[] = {
-            -0.5f,  0.5f, 0.0f,  0.0f, 1.0f,
-            -0.5f, -0.5f, 0.0f,  0.0f, 0.0f,
-             0.5f,  0.5f, 0.0f,  1.0f, 1.0f,
-             0.5f, -0.5f, 0.0f,  1.0f, 0.0f
-        };
-        GLuint VBO;
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-        glEnableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        SpriteQuad quad = { position.x - scale.x * 0.5f, position.y - scale.y * 0.5f, scale.x, scale.y,
+                            0.0f, 1.0f, 1.0f, 0.0f, COLOR_WHITE, glm::radians(rotation) };   // textures are top row first
+        spriteBatch.draw(shaderProgram, textureID, BLEND_ALPHA, quad);
     }
 };
 
-GLuint compileShader(GLenum type, const GLchar* source) {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, nullptr);
-    glCompileShader(shader);
-    GLint success;
-    GLchar infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "Erro na compilação do shader: " << infoLog << std::endl;
-    }
-    return shader;
-}
-
 GLuint createShaderProgram() {
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    GLint success;
-    GLchar infoLog[512];
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cerr << "Erro ao linkar o programa: " << infoLog << std::endl;
-    }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    GLuint program = shaderCache.build("tarefa04", vertexShaderSource, fragmentShaderSource);
+    bindUniformBlocks(program);
     return program;
 }
 
 GLuint loadTexture(const string& path) {
     GLuint textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+    glState.bindTexture(0, GL_TEXTURE_2D, textureID);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    stbi_set_flip_vertically_on_load(true);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = (nrChannels == 4) ? GL_RGBA : GL_RGB;
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else { std::cerr << "Falha ao carregar textura: " << path << std::endl; }
-    stbi_image_free(data);
+    // cooked mips when assetCooker made them, else generated from the PNG
+    if (uploadTexture(path).levels == 0) {
+        glState.bindTexture(0, GL_TEXTURE_2D, 0);   // the name may be reused
+        glDeleteTextures(1, &textureID);
+        textureID = 0;
+    }
     return textureID;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // tarefa04 <n>: adiciona n sprites animados para teste de carga
+    int extraSprites = argc > 1 && isdigit((unsigned char)argv[1][0]) ? atoi(argv[1]) : 0;
+    StartupTrace startup;
+    startup.parseArgs(argc, argv);
     glfwInit();
-    stbi_set_flip_vertically_on_load(true);
+    startup.phase("glfwInit");
+    if (startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Sprites com Textura", nullptr, nullptr);
     if (!window) {
         std::cerr << "Erro ao criar janela GLFW" << std::endl;
@@ -144,17 +110,24 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         std::cerr << "Erro ao inicializar GLAD" << std::endl;
         return -1;
     }
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    startup.phase("glad");
+    if (startup.headless()) glfwSwapInterval(0);
+    glState.viewport(0, 0, WIDTH, HEIGHT);
+    glState.setBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     GLuint shaderProgram = createShaderProgram();
-    glUseProgram(shaderProgram);
+    glState.useProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "tex"), 0);
+    startup.phase("shaders");
+    frameUniforms.init();
+    spriteBatch.init();
+    startup.phase("scene");
     vector<Sprite> sprites;
+    vector<GLuint> characterTextures;
     vector<string> texturePaths = {
         "../assets/sprites/night.png",
         "../assets/sprites/3_Run_005.png",
@@ -168,15 +141,59 @@ int main() {
         else {
             float x = 100.0f + (i - 1) * 140.0f;
             sprites.emplace_back(shaderProgram, tex, glm::vec2(x, 100), glm::vec2(128.0f, 128.0f), 0.0f);
+            if (tex) characterTextures.push_back(tex);
         }
     }
+    startup.phase("textures");
+    if (extraSprites > 0 && characterTextures.empty()) {
+        std::cerr << "Nenhuma textura de personagem carregada; sprites extras ignorados" << std::endl;
+        extraSprites = 0;
+    }
+    sprites.reserve(sprites.size() + extraSprites);
+    for (int i = 0; i < extraSprites; i++) {
+        GLuint tex = characterTextures[i % characterTextures.size()];
+        glm::vec2 pos(rand() % WIDTH, rand() % HEIGHT);
+        Sprite sprite(shaderProgram, tex, pos, glm::vec2(32.0f, 32.0f), float(rand() % 360));
+        sprite.velocity = glm::vec2(rand() % 201 - 100, rand() % 201 - 100);
+        sprite.spin = float(rand() % 181 - 90);
+        sprites.push_back(sprite);
+    }
+    startup.phase("scene");
+    double lastTime = glfwGetTime(), statsTimer = 0;
+    int frames = 0;
     while (!glfwWindowShouldClose(window)) {
+        double now = glfwGetTime();
+        float dt = float(now - lastTime);
+        statsTimer += now - lastTime;
+        frames++;
+        lastTime = now;
         glfwPollEvents();
         glClearColor(0.3f, 0.4f, 0.6f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        for (auto& sprite : sprites) { sprite.draw(); }
+        int fbWidth, fbHeight;
+        glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
+        frameUniforms.update(projection, (float)glfwGetTime(), fbWidth, fbHeight);
+        spriteBatch.beginFrame();
+        for (auto& sprite : sprites) {
+            sprite.update(dt);
+            sprite.draw();
+        }
+        spriteBatch.endFrame();
+        BatchStats batchStats = spriteBatch.takeStats();
+        GLStateStats stats = glState.endFrame();
+        if (statsTimer > 0.5) {
+            char title[192];
+            sprintf(title, "Sprites com Textura | %.0f FPS | %u sprites em %u draws | estado GL: %u emitidas, %u filtradas",
+                    frames / statsTimer, batchStats.sprites, batchStats.draws, stats.issued, stats.filtered);
+            glfwSetWindowTitle(window, title);
+            statsTimer = 0;
+            frames = 0;
+        }
         glfwSwapBuffers(window);
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
+    spriteBatch.destroy();
+    frameUniforms.destroy();
     glfwTerminate();
     return 0;
 }
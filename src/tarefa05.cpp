@@ -3,21 +3,19 @@
 #include <GLFW/glfw3.h>
 #include "stb_image.h"
 #include <iostream>
+#include <vector>
+#include "Animation.h"
+#include "FixedTimestep.h"
+#include "InputQueue.h"
+#include "LayerStack.h"
+#include "ParallaxCompositor.h"
+#include "Replay.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
+#include "TextureLoader.h"
+#include "UniformBuffers.h"
 
 // --- SHADER SOURCES ---
-const char* vertexShaderSource = R"(
-    #version 330 core
-    layout (location = 0) in vec3 aPos;
-    layout (location = 1) in vec2 aTexCoord;
-    out vec2 TexCoord;
-    uniform float offset;
-    uniform float scale;
-    void main() {
-        vec3 pos = aPos * scale;
-        gl_Position = vec4(pos, 1.0);
-        TexCoord = vec2(aTexCoord.x - offset, aTexCoord.y);
-    }
-)";
 const char* fragmentShaderSource = R"(
     #version 330 core
     out vec4 FragColor;
@@ -25,47 +23,164 @@ const char* fragmentShaderSource = R"(
     uniform sampler2D texture1;
     void main() { FragColor = texture(texture1, TexCoord); }
 )";
+// The character is a static unit quad; its frame's UV rect is read from
+// the SpriteFrames table, so animating it only changes the `frame` uniform.
+const char* spriteVertexShaderSource = R"(
+    #version 330 core
+    )" SPRITE_UV_GLSL R"(
+    layout (location = 0) in vec2 aCorner;   // 0..1, y up
+    out vec2 TexCoord;
+    uniform vec4 rect;                       // centre and size in NDC
+    uniform int frame;
+    uniform bool flip;
+    void main() {
+        gl_Position = vec4(rect.xy + (aCorner - 0.5) * rect.zw, 0.0, 1.0);
+        vec4 uv = frameUV[frame];
+        float s = flip ? 1.0 - aCorner.x : aCorner.x;
+        // sheets are uploaded top row first, like the rects
+        TexCoord = vec2(mix(uv.x, uv.z, s), mix(uv.w, uv.y, aCorner.y));
+    }
+)";
 
-// --- LAYER STRUCT ---
-struct Layer {
-    unsigned int textureID;
-    float speed;
-    float offset;
+// --- SIMULATION CONSTANTS ---
+const double TICK_RATE      = 60.0;
+const float  SCROLL_SPEED   = 0.0001f * 60.0f;   // texture widths per second at layer speed 1 (the old 0.0001 per frame at 60 fps)
+const float  JUMP_VELOCITY  = 1.2f;
+const float  GRAVITY        = -2.5f;
+
+// --- ANIMATIONS ---
+// Clips, sheets and frame timings come from assets/animations/tarefa05.anim;
+// the simulation only decides which clip the character is in.
+enum Animation { ANIM_IDLE, ANIM_WALK, ANIM_JUMP, ANIM_ATTACK, ANIM_RUN, ANIM_COUNT };
+const char* animationClips[ANIM_COUNT] = { "idle", "walk", "jump", "attack", "run" };
+float attackDuration = 0.6f;   // length of the attack clip, set once it is loaded
+
+// --- CHARACTER INPUT/STATE ---
+struct CharacterInput {
+    bool left, right, jump, attack, run;
+};
+struct CharacterState {
+    float scroll        = 0.0f;   // texture widths scrolled at layer speed 1
+    float jumpY         = 0.0f;
+    float jumpSpeed     = 0.0f;
+    bool  isJumping     = false;
+    bool  attacking     = false;
+    bool  lastAttack    = false;
+    bool  flip          = false;
+    float attackTimer   = 0.0f;
+    Animation animation = ANIM_IDLE;
 };
 
+// --- SIMULATION STEP (fixed dt, no GL) ---
+void stepCharacter(CharacterState& s, const CharacterInput& in, float dt) {
+    bool running  = in.run && (in.left || in.right);
+    bool isMoving = in.left || in.right;
+    float moveDir = in.right ? -1.0f : (in.left ? 1.0f : 0.0f);
+    if (isMoving) s.scroll += SCROLL_SPEED * (running ? 2.0f : 1.0f) * moveDir * dt;
+
+    // --- JUMP ---
+    if (!s.isJumping && in.jump) {
+        s.isJumping = true;
+        s.jumpSpeed = JUMP_VELOCITY;
+    }
+    if (s.isJumping) {
+        s.jumpY     += s.jumpSpeed * dt;
+        s.jumpSpeed += GRAVITY * dt;
+        if (s.jumpY <= 0.0f) {
+            s.jumpY     = 0.0f;
+            s.isJumping = false;
+            s.jumpSpeed = 0.0f;
+        }
+    }
+
+    // --- FLIP ---
+    if (in.left)  s.flip = true;
+    if (in.right) s.flip = false;
+
+    // --- ATTACK ---
+    if (in.attack && !s.lastAttack && !s.attacking) {
+        s.attacking   = true;
+        s.attackTimer = 0.0f;
+    }
+    s.lastAttack = in.attack;
+    if (s.attacking) {
+        s.attackTimer += dt;
+        if (s.attackTimer >= attackDuration) {
+            s.attacking   = false;
+            s.attackTimer = 0.0f;
+        }
+    }
+
+    // --- ANIMATION STATE ---
+    if (s.attacking)                    s.animation = ANIM_ATTACK;
+    else if (s.isJumping || in.jump)    s.animation = ANIM_JUMP;
+    else if (running)                   s.animation = ANIM_RUN;
+    else if (isMoving)                  s.animation = ANIM_WALK;
+    else                                s.animation = ANIM_IDLE;
+}
+
 // --- WINDOW SIZE CONSTANTS ---
 const unsigned int SCR_WIDTH  = 800;
 const unsigned int SCR_HEIGHT = 600;
 
 // --- TEXTURE LOADING FUNCTION ---
+// Cooked mips when assetCooker made them (TextureLoader.h), else the PNG.
 unsigned int loadTexture(const char* path) {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true); 
-    unsigned char *data = stbi_load(path, &width, &height, &nrChannels, STBI_rgb_alpha);
-    if (data) {
-        GLenum format = GL_RGBA;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    } else {
-        std::cout << "failed to load texture " << path << std::endl;
-    }
-    stbi_image_free(data);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    uploadTexture(path);
     return textureID;
 }
 
-int main() {
+// --- INPUT ---
+// Keys are queued by the callback and applied per tick, so the session can
+// be recorded and replayed (--record ARQ, --replay ARQ [--headless]).
+enum Action { ACTION_LEFT, ACTION_RIGHT, ACTION_JUMP, ACTION_ATTACK, ACTION_RUN };
+ReplaySession session;
+StartupTrace startup;
+InputActions actions;
+
+void keyCallback(GLFWwindow* window, int key, int, int action, int mods) {
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
+    session.push(InputEvent::key(glfwGetTime(), key, action, mods));
+}
+
+// A tap shorter than a tick still jumps or attacks.
+CharacterInput tickInput() {
+    CharacterInput input;
+    input.left   = actions.held(ACTION_LEFT);
+    input.right  = actions.held(ACTION_RIGHT);
+    input.jump   = actions.held(ACTION_JUMP) || actions.pressed(ACTION_JUMP);
+    input.attack = actions.held(ACTION_ATTACK) || actions.pressed(ACTION_ATTACK);
+    input.run    = actions.held(ACTION_RUN);
+    return input;
+}
+
+int main(int argc, char** argv) {
+    if (!session.parseArgs(argc, argv)) return 1;
+    startup.parseArgs(argc, argv);
+    uint32_t seed = 0;
+    std::string payload;
+    session.start(seed, payload);
+    actions.bind(GLFW_KEY_A, ACTION_LEFT);
+    actions.bind(GLFW_KEY_D, ACTION_RIGHT);
+    actions.bind(GLFW_KEY_W, ACTION_JUMP);
+    actions.bind(GLFW_KEY_LEFT_CONTROL, ACTION_ATTACK);
+    actions.bind(GLFW_KEY_LEFT_SHIFT, ACTION_RUN);
+
     // --- GLFW/GLAD/OPENGL INIT ---
+    startup.phase("scene");
     glfwInit();
+    startup.phase("glfwInit");
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (session.headless() || startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "parallax", NULL, NULL);
     if (window == NULL) {
         std::cout << "failed to create glfw window\n";
@@ -73,249 +188,143 @@ int main() {
         return -1;
     }
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    startup.phase("glad");
+    glfwSetKeyCallback(window, keyCallback);
+    if (session.replaying() || startup.headless()) glfwSwapInterval(0);
 
-    // --- BLENDING/SHADER/VAO/VBO SETUP ---
+    // --- BLENDING/SHADER SETUP ---
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
-    unsigned int shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    float quadVertices[] = {
-        -1.0f,  1.0f, 0.0f,  0.0f, 1.0f, 
-        -1.0f, -1.0f, 0.0f,  0.0f, 0.0f, 
-         1.0f, -1.0f, 0.0f,  1.0f, 0.0f, 
-        -1.0f,  1.0f, 0.0f,  0.0f, 1.0f, 
-         1.0f, -1.0f, 0.0f,  1.0f, 0.0f, 
-         1.0f,  1.0f, 0.0f,  1.0f, 1.0f
-    };
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glUseProgram(shaderProgram);
-    glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0);
+    unsigned int spriteProgram = shaderCache.build("tarefa05", spriteVertexShaderSource, fragmentShaderSource);
+    bindUniformBlocks(spriteProgram);
+    startup.phase("shaders");
 
     // --- LAYER SETUP ---
-    const char* layerPaths[6] = {
-        "../assets/layers/sky_pale.png",
-        "../assets/layers/houses3_pale.png",
-        "../assets/layers/houded2_pale.png",
-        "../assets/layers/houses1_pale.png",
-        "../assets/layers/crosswalk_pale.png",
-        "../assets/layers/road_pale.png"
-    };
-    float minSpeed = 0.05f;
-    float maxSpeed = 1.50f;
-    float scale    = 1.0f;
-    Layer layers[6];
-    for (int i = 0; i < 6; ++i) {
-        layers[i].textureID = loadTexture(layerPaths[i]);
-        layers[i].speed     = minSpeed + (maxSpeed - minSpeed) * (float)i / 5.0f;
-        layers[i].offset    = 0.0f;
+    // Layers and speeds come from tarefa05.layers; all of them are
+    // composited in a single full-screen pass, unless they are too large
+    // for one texture array, in which case a LayerStack pages them in.
+    LayerConfig layerConfig;
+    ParallaxCompositor parallax;
+    LayerStack layerStack;
+    if (!layerConfig.load(std::string("../assets/layers/tarefa05.layers"))) {
+        glfwTerminate();
+        return -1;
     }
+    bool composited = parallax.init(layerConfig);
+    if (composited) {
+        parallax.setBackground(0.2f, 0.3f, 0.3f);
+    } else if (layerStack.load(layerConfig)) {
+        layerStack.init();
+    } else {
+        glfwTerminate();
+        return -1;
+    }
+    startup.phase("layers");
 
-    // --- SPRITE TEXTURE/FRAME CONSTANTS ---
-    unsigned int idleTexture   = loadTexture("../assets/sprites/Idle.png");
-    unsigned int walkTexture   = loadTexture("../assets/sprites/Walk.png");
-    unsigned int jumpTexture   = loadTexture("../assets/sprites/Jump.png");
-    unsigned int attackTexture = loadTexture("../assets/sprites/Attack_2.png");
-    unsigned int runTexture    = loadTexture("../assets/sprites/Run.png");
-    int currentFrame = 0;
-    int idleFrames   = 6;
-    int walkFrames   = 8;
-    int jumpFrames   = 12;
-    int attackFrames = 4;
-    int runFrames    = 8;
+    // --- ANIMATION CLIPS AND SHEET TEXTURES ---
+    AnimationLibrary library;
+    int clipIds[ANIM_COUNT];
+    if (!library.load(std::string("../assets/animations/tarefa05.anim"))) {
+        glfwTerminate();
+        return -1;
+    }
+    for (int i = 0; i < ANIM_COUNT; ++i) {
+        clipIds[i] = library.clipId(animationClips[i]);
+        if (clipIds[i] < 0) {
+            std::cout << "missing clip " << animationClips[i] << " in tarefa05.anim\n";
+            glfwTerminate();
+            return -1;
+        }
+    }
+    attackDuration = library.clip(clipIds[ANIM_ATTACK]).seconds;
+    std::vector<unsigned int> sheetTextures;
+    for (const AnimSheet& sheet : library.getSheets()) sheetTextures.push_back(loadTexture(sheet.path.c_str()));
+    startup.phase("textures");
+    Animator animator(&library);
+    int character = animator.add(clipIds[ANIM_IDLE]);
+    SpriteUVTable uvTable;
+    uvTable.init(&library.frameRectData()->u0, (int)library.totalFrames());
+    glUseProgram(spriteProgram);
+    glUniform1i(glGetUniformLocation(spriteProgram, "texture1"), 0);
+    GLint rectLocation  = glGetUniformLocation(spriteProgram, "rect");
+    GLint frameLocation = glGetUniformLocation(spriteProgram, "frame");
+    GLint flipLocation  = glGetUniformLocation(spriteProgram, "flip");
 
-    // --- ANIMATION/CHARACTER STATE VARS ---
-    bool walking        = false;
-    bool attacking      = false;
-    bool jumping        = false;
-    bool isJumping      = false;
-    float frameDuration = 0.15f;
-    float frameTimer    = 0.0f;
-    float attackTimer   = 0.0f;
+    // --- CHARACTER STATE VARS ---
+    CharacterState state, previous;
+    FixedTimestep timestep(TICK_RATE);
     float charX         = 0.0f;
     float charY         = -0.5f;
     float charW         = 0.2f;
     float charH         = 0.4f;
-    float jumpVelocity  = 1.2f;
-    float gravity       = -2.5f;
-    float jumpY         = 0.0f;
-    float jumpSpeed     = 0.0f;
-    float lastTime      = glfwGetTime();
-    float attackDuration = attackFrames * frameDuration;
-    float charVertices[30];
+    double lastTime     = glfwGetTime();
+    uint64_t tickCount  = 0;
 
-    // --- CHARACTER VAO/VBO SETUP ---
+    // --- CHARACTER VAO/VBO SETUP (uploaded once) ---
+    float charCorners[] = { 0.0f, 0.0f,  1.0f, 0.0f,  0.0f, 1.0f,  1.0f, 1.0f };
     unsigned int charVBO, charVAO;
     glGenVertexArrays(1, &charVAO);
     glGenBuffers(1, &charVBO);
     glBindVertexArray(charVAO);
     glBindBuffer(GL_ARRAY_BUFFER, charVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(charVertices), charVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(charCorners), charCorners, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    startup.phase("scene");
     
     // --- MAIN GAME LOOP ---
-    while (!glfwWindowShouldClose(window)) {
-        float now   = glfwGetTime();
-        float delta = now - lastTime;
-        lastTime    = now;
-        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
-
-        // --- INPUT HANDLING ---
-        bool leftPressed   = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
-        bool rightPressed  = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
-        bool jumpPressed   = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
-        bool attackPressed = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS;
-        bool running       = (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) && (leftPressed || rightPressed);
-
-        // --- MOVEMENT LOGIC ---
-        float speedMultiplier = running ? 2.0f : 1.0f;
-        float baseSpeed       = 0.0001f;
-        bool isMoving         = rightPressed || leftPressed;
-        float moveDir         = rightPressed ? -1.0f : (leftPressed ? 1.0f : 0.0f);
-        if (isMoving) {
-            float moveSpeed = baseSpeed * speedMultiplier * moveDir;
-            for (int i = 0; i < 6; ++i) layers[i].offset += layers[i].speed * moveSpeed;
-        }
-        walking = isMoving;
-        jumping = jumpPressed;
-
-        // --- JUMP LOGIC ---
-        if (!isJumping && jumpPressed) {
-            isJumping = true;
-            jumpSpeed = jumpVelocity;
-        }
-        if (isJumping) {
-            jumpY     += jumpSpeed * delta;
-            jumpSpeed += gravity * delta;
-            if (jumpY <= 0.0f) {
-                jumpY     = 0.0f;
-                isJumping = false;
-                jumpSpeed = 0.0f;
-            }
-        }
-
-        // --- FLIP SPRITE ---
-        static bool lastFlip       = false;
-        if (leftPressed) lastFlip  = true;
-        if (rightPressed) lastFlip = false;
-        bool flip = lastFlip;
+    while (!glfwWindowShouldClose(window) && !session.done()) {
+        double now   = glfwGetTime();
+        double delta = session.frameDelta(now - lastTime, timestep.step());
+        lastTime     = now;
 
-        // --- ATTACK LOGIC ---
-        static bool lastAttackPressed = false;
-        if (attackPressed && !lastAttackPressed && !attacking) {
-            attacking    = true;
-            attackTimer  = 0.0f;
-            currentFrame = 0;
-        }
-        lastAttackPressed = attackPressed;
-        if (attacking) {
-            attackTimer += delta;
-            if (attackTimer >= attackDuration) {
-                attacking   = false;
-                attackTimer = 0.0f;
-            }
+        // --- FIXED-STEP SIMULATION ---
+        timestep.accumulate(delta);
+        while (timestep.tick()) {
+            session.consume(tickCount++, now - timestep.lag(), [](const InputEvent& e) { actions.apply(e); });
+            previous = state;
+            stepCharacter(state, tickInput(), (float)timestep.step());
+            animator.play(character, clipIds[state.animation]);
+            animator.update((float)timestep.step());
+            actions.endTick();
         }
+        float alpha = timestep.alpha();
 
-        // --- ANIMATION STATE ---
-        int totalFrames;
-        unsigned int charTex;
-        if (attacking) {
-            totalFrames  = attackFrames;
-            charTex      = attackTexture;
-            currentFrame = (int)((attackTimer / attackDuration) * attackFrames);
-            if (currentFrame >= attackFrames) currentFrame = attackFrames - 1;
-        } else if (isJumping || jumping) {
-            totalFrames = jumpFrames;
-            charTex     = jumpTexture;
-        } else if (running) {
-            totalFrames = runFrames;
-            charTex     = runTexture;
-        } else if (walking) {
-            totalFrames = walkFrames;
-            charTex     = walkTexture;
+        // --- DRAW LAYERS (covers the screen, no clear needed) ---
+        float scroll = previous.scroll + (state.scroll - previous.scroll) * alpha;
+        float cameraX = -scroll * layerConfig.viewWidth;
+        if (composited) {
+            parallax.draw(cameraX);
         } else {
-            totalFrames = idleFrames;
-            charTex     = idleTexture;
-        }
-        if (!attacking) {
-            frameTimer += delta;
-            if (frameTimer >= frameDuration) {
-                frameTimer   = 0.0f;
-                currentFrame = (currentFrame + 1) % totalFrames;
-            }
-        }
-
-        // --- SPRITE UVs ---
-        float u0 = (float)currentFrame / totalFrames;
-        float u1 = (float)(currentFrame + 1) / totalFrames;
-        if (flip) {
-            float tmp = u0;
-            u0        = u1;
-            u1        = tmp;
-        }
-
-        // --- CHARACTER VERTEX UPDATE ---
-        float charYdraw  = charY + jumpY;
-        charVertices[0]  = charX - charW/2; charVertices[1]  = charYdraw + charH/2; charVertices[2]  = 0.0f; charVertices[3]  = u0; charVertices[4]  = 1.0f;
-        charVertices[5]  = charX - charW/2; charVertices[6]  = charYdraw - charH/2; charVertices[7]  = 0.0f; charVertices[8]  = u0; charVertices[9]  = 0.0f;
-        charVertices[10] = charX + charW/2; charVertices[11] = charYdraw - charH/2; charVertices[12] = 0.0f; charVertices[13] = u1; charVertices[14] = 0.0f;
-        charVertices[15] = charX - charW/2; charVertices[16] = charYdraw + charH/2; charVertices[17] = 0.0f; charVertices[18] = u0; charVertices[19] = 1.0f;
-        charVertices[20] = charX + charW/2; charVertices[21] = charYdraw - charH/2; charVertices[22] = 0.0f; charVertices[23] = u1; charVertices[24] = 0.0f;
-        charVertices[25] = charX + charW/2; charVertices[26] = charYdraw + charH/2; charVertices[27] = 0.0f; charVertices[28] = u1; charVertices[29] = 1.0f;
-
-        // --- DRAW SCENE ---
-        glBindBuffer(GL_ARRAY_BUFFER, charVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(charVertices), charVertices, GL_DYNAMIC_DRAW);
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glBindVertexArray(VAO);
-        glUseProgram(shaderProgram);
-
-        // --- DRAW LAYERS ---
-        for (int i = 0; i < 6; ++i) {
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, layers[i].textureID);
-            glUniform1f(glGetUniformLocation(shaderProgram, "offset"), layers[i].offset);
-            glUniform1f(glGetUniformLocation(shaderProgram, "scale"), scale);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            layerStack.update(cameraX, 0.0f);
+            layerStack.draw();
         }
 
         // --- DRAW CHARACTER ---
+        float jumpY = previous.jumpY + (state.jumpY - previous.jumpY) * alpha;
         glBindVertexArray(charVAO);
+        glUseProgram(spriteProgram);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, charTex);
-        glUniform1f(glGetUniformLocation(shaderProgram, "offset"), 0.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram, "scale"), 1.0f);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindTexture(GL_TEXTURE_2D, sheetTextures[animator.sheet(character)]);
+        glUniform4f(rectLocation, charX, charY + jumpY, charW, charH);
+        glUniform1i(frameLocation, (int)animator.frameId(character));
+        glUniform1i(flipLocation, state.flip);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
         glfwSwapBuffers(window);
+        session.endFrame();
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
         glfwPollEvents();
     }
+    session.finish("tarefa05");
 
     // --- CLEANUP ---
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    parallax.destroy();
+    layerStack.destroy();
+    uvTable.destroy();
     glDeleteVertexArrays(1, &charVAO);
     glDeleteBuffers(1, &charVBO);
     glfwTerminate();
@@ -0,0 +1,560 @@
+// Offline texture cooker. Converts the images under assets/ into .ctex
+// files (CookedTexture.h) under assets/cooked/: mip chain generated here,
+// alpha prepared as the game wants it and, if the rules ask for it, block
+// compressed to BC1, BC3 or BC7, so the game uploads them without decoding
+// a PNG. A manifest keeps the hashes of every source, its settings and its
+// output; a second run only cooks what changed.
+//
+//   assetCooker [opções] [pasta de assets]   (padrão ../assets)
+//     --out DIR         pasta de saída (padrão <assets>/cooked)
+//     --rules ARQ       regras de cozimento (padrão <assets>/cook.rules)
+//     --force           cozinha tudo, mesmo o que não mudou
+//     --threads N       threads de codificação (padrão: todas)
+//
+// Regras, uma por linha, a primeira que casa vale (caminhos relativos à
+// pasta de assets, * casa qualquer sequência):
+//   <padrão> <rgba8|bc1|bc3|bc7> [mips] [premultiply] [cutout]
+
+// --- INCLUDE DEFINITIONS ---
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "CookedTexture.h"
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+// Bump when the encoders or the .ctex flags change, so everything is cooked again.
+const uint32_t COOKER_VERSION = 2;
+
+// --- RULES ---
+struct CookRule {
+    std::string pattern;
+    uint32_t format = CTEX_RGBA8;
+    bool mips = false, premultiply = false, cutout = false;
+
+    std::string settings() const {
+        std::string s = cookedFormatName(format);
+        if (mips) s += " mips";
+        if (premultiply) s += " premultiply";
+        if (cutout) s += " cutout";
+        return s;
+    }
+};
+
+static bool wildcardMatch(const char* pattern, const char* text) {
+    if (*pattern == '\0') return *text == '\0';
+    if (*pattern == '*') return wildcardMatch(pattern + 1, text) || (*text && wildcardMatch(pattern, text + 1));
+    return *text == *pattern && wildcardMatch(pattern + 1, text + 1);
+}
+
+static bool loadRules(const std::string& path, std::vector<CookRule>& rules) {
+    std::ifstream file(path);
+    if (!file) { fprintf(stderr, "Erro ao abrir %s\n", path.c_str()); return false; }
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        CookRule rule;
+        std::string format, option;
+        if (!(in >> rule.pattern)) continue;
+        in >> format;
+        if (format == "rgba8") rule.format = CTEX_RGBA8;
+        else if (format == "bc1") rule.format = CTEX_BC1;
+        else if (format == "bc3") rule.format = CTEX_BC3;
+        else if (format == "bc7") rule.format = CTEX_BC7;
+        else { fprintf(stderr, "%s:%d: formato desconhecido '%s'\n", path.c_str(), number, format.c_str()); return false; }
+        while (in >> option) {
+            if (option == "mips") rule.mips = true;
+            else if (option == "premultiply") rule.premultiply = true;
+            else if (option == "cutout") rule.cutout = true;
+            else { fprintf(stderr, "%s:%d: opção desconhecida '%s'\n", path.c_str(), number, option.c_str()); return false; }
+        }
+        rules.push_back(rule);
+    }
+    return true;
+}
+
+// --- MIP CHAIN ---
+// 2x2 box filter (odd edges clamp). Straight-alpha colour is weighted by
+// alpha so transparent texels don't darken the edges of smaller levels.
+static std::vector<unsigned char> downsample(const std::vector<unsigned char>& src, int w, int h, bool premultiplied) {
+    int dw = std::max(1, w / 2), dh = std::max(1, h / 2);
+    std::vector<unsigned char> dst((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; ++y) {
+        for (int x = 0; x < dw; ++x) {
+            float sum[4] = {}, weight = 0.0f;
+            for (int sy = 0; sy < 2; ++sy) {
+                for (int sx = 0; sx < 2; ++sx) {
+                    const unsigned char* p = &src[((size_t)std::min(2 * y + sy, h - 1) * w + std::min(2 * x + sx, w - 1)) * 4];
+                    float a = premultiplied ? 1.0f : p[3] / 255.0f;
+                    for (int c = 0; c < 3; ++c) sum[c] += p[c] * a;
+                    sum[3] += p[3];
+                    weight += a;
+                }
+            }
+            unsigned char* q = &dst[((size_t)y * dw + x) * 4];
+            for (int c = 0; c < 3; ++c) q[c] = weight > 0.0f ? (unsigned char)(sum[c] / weight + 0.5f) : 0;
+            q[3] = (unsigned char)(sum[3] / 4.0f + 0.5f);
+        }
+    }
+    return dst;
+}
+
+// --- BLOCK ENCODING ---
+// Shared by the encoders: endpoints along the principal axis of the block's
+// colours, then one least-squares refit against the chosen weights.
+struct Block {
+    float texels[16][4];
+};
+
+static void principalEndpoints(const Block& block, int channels, float lo[4], float hi[4]) {
+    float mean[4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < channels; ++c) mean[c] += block.texels[i][c] / 16.0f;
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b)
+                cov[a][b] += (block.texels[i][a] - mean[a]) * (block.texels[i][b] - mean[b]);
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = {}, length = 0.0f;
+        for (int a = 0; a < channels; ++a) {
+            for (int b = 0; b < channels; ++b) next[a] += cov[a][b] * axis[b];
+            length += next[a] * next[a];
+        }
+        if (length < 1e-12f) break;
+        length = std::sqrt(length);
+        for (int a = 0; a < channels; ++a) axis[a] = next[a] / length;
+    }
+    float tMin = 1e30f, tMax = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c) t += (block.texels[i][c] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < channels; ++c) {
+        lo[c] = std::min(255.0f, std::max(0.0f, mean[c] + tMin * axis[c]));
+        hi[c] = std::min(255.0f, std::max(0.0f, mean[c] + tMax * axis[c]));
+    }
+}
+
+// Endpoints minimising the squared error of (1 - w) * lo + w * hi.
+static bool refitEndpoints(const Block& block, int channels, const float weights[16], float lo[4], float hi[4]) {
+    float aa = 0, ab = 0, bb = 0, ax[4] = {}, bx[4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float a = 1.0f - weights[i], b = weights[i];
+        aa += a * a; ab += a * b; bb += b * b;
+        for (int c = 0; c < channels; ++c) { ax[c] += a * block.texels[i][c]; bx[c] += b * block.texels[i][c]; }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) return false;
+    for (int c = 0; c < channels; ++c) {
+        lo[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / det));
+        hi[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / det));
+    }
+    return true;
+}
+
+static float distance2(const float* a, const float* b, int channels) {
+    float d = 0.0f;
+    for (int c = 0; c < channels; ++c) d += (a[c] - b[c]) * (a[c] - b[c]);
+    return d;
+}
+
+// BC1 colour: 5:6:5 endpoints, 2-bit indices, always the four-colour mode
+// (color0 > color1), which is also how BC3 reads its colour half.
+static uint16_t pack565(const float c[3]) {
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f), g = (int)(c[1] * 63.0f / 255.0f + 0.5f), b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack565(uint16_t v, float c[3]) {
+    int r = v >> 11, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (float)((r << 3) | (r >> 2));
+    c[1] = (float)((g << 2) | (g >> 4));
+    c[2] = (float)((b << 3) | (b >> 2));
+}
+
+// Returns the squared error; `weights` gets where each texel sits between
+// lo (0) and hi (1), for the refit.
+static float encodeColorEndpoints(const Block& block, const float lo[3], const float hi[3], unsigned char* out, float weights[16]) {
+    uint16_t c0 = pack565(hi), c1 = pack565(lo);
+    bool swapped = c0 < c1;
+    if (swapped) std::swap(c0, c1);
+    static const float towardsColor0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float palette[4][3];
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+    uint32_t indices = 0;
+    float error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        float bestError = 1e30f;
+        for (int p = 0; p < (c0 == c1 ? 1 : 4); ++p) {
+            float e = distance2(block.texels[i], palette[p], 3);
+            if (e < bestError) { bestError = e; best = p; }
+        }
+        indices |= (uint32_t)best << (2 * i);
+        weights[i] = swapped ? 1.0f - towardsColor0[best] : towardsColor0[best];
+        error += bestError;
+    }
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    for (int b = 0; b < 4; ++b) out[4 + b] = (indices >> (8 * b)) & 0xFF;
+    return error;
+}
+
+static void encodeBC1(const Block& block, unsigned char* out) {
+    float lo[4], hi[4];
+    principalEndpoints(block, 3, lo, hi);
+    float weights[16];
+    float error = encodeColorEndpoints(block, lo, hi, out, weights);
+    float refitLo[4], refitHi[4];
+    if (!refitEndpoints(block, 3, weights, refitLo, refitHi)) return;
+    unsigned char candidate[8];
+    if (encodeColorEndpoints(block, refitLo, refitHi, candidate, weights) < error) memcpy(out, candidate, 8);
+}
+
+// BC3: an 8-value alpha block (BC4 layout) followed by a BC1 colour block.
+static void encodeAlpha(const Block& block, unsigned char* out) {
+    float aMin = 255.0f, aMax = 0.0f;
+    for (int i = 0; i < 16; ++i) { aMin = std::min(aMin, block.texels[i][3]); aMax = std::max(aMax, block.texels[i][3]); }
+    int a0 = (int)(aMax + 0.5f), a1 = (int)(aMin + 0.5f);
+    float palette[8] = { (float)a0, (float)a1 };
+    for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7.0f;
+    uint64_t indices = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        for (int p = 1; p < (a0 == a1 ? 1 : 8); ++p)
+            if (std::fabs(palette[p] - block.texels[i][3]) < std::fabs(palette[best] - block.texels[i][3])) best = p;
+        indices |= (uint64_t)best << (3 * i);
+    }
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for (int b = 0; b < 6; ++b) out[2 + b] = (indices >> (8 * b)) & 0xFF;
+}
+
+static void encodeBC3(const Block& block, unsigned char* out) {
+    encodeAlpha(block, out);
+    encodeBC1(block, out + 8);
+}
+
+// BC7, mode 6 only: one RGBA subset, 7-bit endpoints plus a p-bit each,
+// 4-bit indices. The other modes (partitions, separate alpha) would help
+// blocks with several distinct colours; mode 6 alone is already well
+// above BC1/BC3 quality and keeps the encoder small.
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BitWriter {
+    unsigned char* out;
+    int bit = 0;
+    void write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++bit)
+            if ((value >> i) & 1) out[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+    }
+};
+
+// Best 7-bit value and p-bit for an 8-bit endpoint; the p-bit is shared by
+// the four channels, so it's chosen for the endpoint as a whole.
+static void quantizeBC7(const float e[4], int q[4], int& pbit) {
+    float bestError = 1e30f;
+    for (int p = 0; p < 2; ++p) {
+        int candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            candidate[c] = std::min(127, std::max(0, (int)std::floor((e[c] - p) / 2.0f + 0.5f)));
+            float v = (float)(candidate[c] * 2 + p);
+            error += (v - e[c]) * (v - e[c]);
+        }
+        if (error < bestError) { bestError = error; pbit = p; memcpy(q, candidate, sizeof(candidate)); }
+    }
+}
+
+static float encodeBC7Endpoints(const Block& block, const float lo[4], const float hi[4], unsigned char* out, float weights[16]) {
+    int q[2][4], p[2];
+    quantizeBC7(lo, q[0], p[0]);
+    quantizeBC7(hi, q[1], p[1]);
+    float palette[16][4];
+    for (int c = 0; c < 4; ++c) {
+        int e0 = q[0][c] * 2 + p[0], e1 = q[1][c] * 2 + p[1];
+        for (int w = 0; w < 16; ++w) palette[w][c] = (float)(((64 - BC7_WEIGHTS[w]) * e0 + BC7_WEIGHTS[w] * e1 + 32) >> 6);
+    }
+    int indices[16];
+    float error = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        float bestError = 1e30f;
+        for (int w = 0; w < 16; ++w) {
+            float e = distance2(block.texels[i], palette[w], 4);
+            if (e < bestError) { bestError = e; best = w; }
+        }
+        indices[i] = best;
+        weights[i] = BC7_WEIGHTS[best] / 64.0f;
+        error += bestError;
+    }
+    // the first index is stored with its top bit implied zero
+    if (indices[0] >= 8) {
+        std::swap(q[0], q[1]);
+        std::swap(p[0], p[1]);
+        for (int i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+    }
+    memset(out, 0, 16);
+    BitWriter bits{ out };
+    bits.write(1 << 6, 7);
+    for (int c = 0; c < 4; ++c) { bits.write(q[0][c], 7); bits.write(q[1][c], 7); }
+    bits.write(p[0], 1);
+    bits.write(p[1], 1);
+    bits.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i) bits.write(indices[i], 4);
+    return error;
+}
+
+static void encodeBC7(const Block& block, unsigned char* out) {
+    float lo[4], hi[4];
+    principalEndpoints(block, 4, lo, hi);
+    float weights[16];
+    float error = encodeBC7Endpoints(block, lo, hi, out, weights);
+    float refitLo[4], refitHi[4];
+    if (!refitEndpoints(block, 4, weights, refitLo, refitHi)) return;
+    unsigned char candidate[16];
+    if (encodeBC7Endpoints(block, refitLo, refitHi, candidate, weights) < error) memcpy(out, candidate, 16);
+}
+
+static std::vector<unsigned char> encodeLevel(const std::vector<unsigned char>& rgba, int w, int h, uint32_t format) {
+    if (format == CTEX_RGBA8) return rgba;
+    size_t blockSize = format == CTEX_BC1 ? 8 : 16;
+    std::vector<unsigned char> out(cookedLevelSize(format, w, h));
+    unsigned char* dst = out.data();
+    for (int by = 0; by < h; by += 4) {
+        for (int bx = 0; bx < w; bx += 4, dst += blockSize) {
+            Block block;
+            for (int i = 0; i < 16; ++i) {
+                // blocks past the edge repeat the last row / column
+                const unsigned char* p = &rgba[((size_t)std::min(by + i / 4, h - 1) * w + std::min(bx + i % 4, w - 1)) * 4];
+                for (int c = 0; c < 4; ++c) block.texels[i][c] = p[c];
+            }
+            if (format == CTEX_BC1) encodeBC1(block, dst);
+            else if (format == CTEX_BC3) encodeBC3(block, dst);
+            else encodeBC7(block, dst);
+        }
+    }
+    return out;
+}
+
+// --- COOKING ---
+struct CookJob {
+    std::string relative;           // path under the assets directory
+    const CookRule* rule = nullptr;
+    uint64_t sourceHash = 0, settingsHash = 0, outputHash = 0;
+    bool skipped = false, failed = false;
+    const char* reason = "";
+    size_t sourceBytes = 0, outputBytes = 0;
+    int width = 0, height = 0, levels = 0;
+};
+
+static bool readFile(const fs::path& path, std::string& bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::ostringstream content;
+    content << file.rdbuf();
+    bytes = content.str();
+    return true;
+}
+
+static void appendU32(std::string& out, uint32_t value) {
+    out.append((const char*)&value, 4);
+}
+
+static void cook(CookJob& job, const std::string& source, const fs::path& output) {
+    int channels;
+    unsigned char* pixels = stbi_load_from_memory((const unsigned char*)source.data(), (int)source.size(),
+                                                  &job.width, &job.height, &channels, 4);
+    if (!pixels) { job.failed = true; job.reason = stbi_failure_reason(); return; }
+    int w = job.width, h = job.height;
+    std::vector<unsigned char> level(pixels, pixels + (size_t)w * h * 4);
+    stbi_image_free(pixels);
+    const CookRule& rule = *job.rule;
+    prepareTexels(level.data(), (size_t)w * h, rule.cutout, rule.premultiply);
+
+    std::string out = "CTEX";
+    appendU32(out, CTEX_VERSION);
+    appendU32(out, rule.format);
+    appendU32(out, (rule.premultiply ? CTEX_PREMULTIPLIED : 0) | (rule.cutout ? CTEX_CUTOUT : 0));
+    appendU32(out, w);
+    appendU32(out, h);
+    size_t countAt = out.size();
+    appendU32(out, 0);
+    for (;;) {
+        std::vector<unsigned char> encoded = encodeLevel(level, w, h, rule.format);
+        appendU32(out, w);
+        appendU32(out, h);
+        appendU32(out, (uint32_t)encoded.size());
+        out.append((const char*)encoded.data(), encoded.size());
+        ++job.levels;
+        if (!rule.mips || (w == 1 && h == 1)) break;
+        level = downsample(level, w, h, rule.premultiply);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    uint32_t levels = (uint32_t)job.levels;
+    memcpy(&out[countAt], &levels, 4);
+
+    // written aside and renamed, so a running game never reads half a file
+    std::error_code error;
+    fs::create_directories(output.parent_path(), error);
+    fs::path temporary = output;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.write(out.data(), out.size())) { job.failed = true; job.reason = "falha ao gravar"; return; }
+    }
+    fs::rename(temporary, output, error);
+    if (error) { job.failed = true; job.reason = "falha ao gravar"; return; }
+    job.outputHash = fnv1a64(out.data(), out.size());
+    job.outputBytes = out.size();
+}
+
+static bool isImage(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".tga";
+}
+
+// --- MAIN ---
+int main(int argc, char** argv) {
+    std::string assets = "../assets", outDir, rulesPath;
+    bool force = false;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc)              outDir = argv[++i];
+        else if (arg == "--rules" && i + 1 < argc)       rulesPath = argv[++i];
+        else if (arg == "--force")                       force = true;
+        else if (arg == "--threads" && i + 1 < argc)     threads = (unsigned)atoi(argv[++i]);
+        else if (arg.rfind("--", 0) != 0)                assets = arg;
+        else { fprintf(stderr, "Opção desconhecida: %s\n", argv[i]); return 1; }
+    }
+    if (outDir.empty()) outDir = assets + "/cooked";
+    if (rulesPath.empty()) rulesPath = assets + "/cook.rules";
+    std::vector<CookRule> rules;
+    if (!loadRules(rulesPath, rules)) return 1;
+
+    // manifest: <source> <source hash> <settings hash> <output hash>
+    fs::path manifestPath = fs::path(outDir) / "manifest.txt";
+    std::map<std::string, CookJob> previous;
+    {
+        std::ifstream manifest(manifestPath);
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::istringstream in(line);
+            CookJob entry;
+            if (line.empty() || line[0] == '#') continue;
+            in >> entry.relative >> std::hex >> entry.sourceHash >> entry.settingsHash >> entry.outputHash;
+            if (in) previous[entry.relative] = entry;
+        }
+    }
+
+    std::vector<CookJob> jobs;
+    std::error_code error;
+    fs::path outRoot = fs::absolute(outDir, error);
+    for (fs::recursive_directory_iterator it(assets, error), end; it != end; it.increment(error)) {
+        if (fs::equivalent(it->path(), outRoot, error)) { it.disable_recursion_pending(); continue; }
+        if (!it->is_regular_file() || !isImage(it->path())) continue;
+        CookJob job;
+        job.relative = fs::relative(it->path(), assets).generic_string();
+        for (const CookRule& rule : rules)
+            if (wildcardMatch(rule.pattern.c_str(), job.relative.c_str())) { job.rule = &rule; break; }
+        if (job.rule) jobs.push_back(job);
+    }
+    if (error) { fprintf(stderr, "Erro ao percorrer %s: %s\n", assets.c_str(), error.message().c_str()); return 1; }
+    std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) { return a.relative < b.relative; });
+
+    ThreadPool pool(threads);
+    std::mutex printMutex;
+    auto begin = std::chrono::steady_clock::now();
+    for (CookJob& job : jobs) {
+        pool.submit([&] {
+            fs::path source = fs::path(assets) / job.relative;
+            fs::path output = fs::path(outDir) / job.relative;
+            output.replace_extension(".ctex");
+            std::string bytes;
+            if (!readFile(source, bytes)) {
+                job.failed = true;
+                std::lock_guard<std::mutex> lock(printMutex);
+                fprintf(stderr, "Erro ao ler %s\n", source.string().c_str());
+                return;
+            }
+            std::string settings = job.rule->settings();
+            job.sourceBytes = bytes.size();
+            job.sourceHash = fnv1a64(bytes.data(), bytes.size());
+            job.settingsHash = fnv1a64(settings.data(), settings.size(), fnv1a64(&COOKER_VERSION, sizeof(COOKER_VERSION)));
+            auto found = previous.find(job.relative);
+            std::error_code statError;
+            if (!force && found != previous.end() && found->second.sourceHash == job.sourceHash &&
+                found->second.settingsHash == job.settingsHash && fs::exists(output, statError)) {
+                job.skipped = true;
+                job.outputHash = found->second.outputHash;
+                job.outputBytes = (size_t)fs::file_size(output, statError);
+                return;
+            }
+            cook(job, bytes, output);
+            std::lock_guard<std::mutex> lock(printMutex);
+            if (job.failed) fprintf(stderr, "Erro ao cozinhar %s: %s\n", job.relative.c_str(), job.reason);
+            else printf("  %-40s %-26s %5dx%-5d %2d niveis %8.1f KB\n", job.relative.c_str(), settings.c_str(),
+                        job.width, job.height, job.levels, job.outputBytes / 1024.0);
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // outputs whose source is gone or no longer matches a rule
+    int removed = 0;
+    for (const auto& entry : previous) {
+        bool kept = std::any_of(jobs.begin(), jobs.end(), [&](const CookJob& job) { return job.relative == entry.first; });
+        if (kept) continue;
+        fs::path output = fs::path(outDir) / entry.first;
+        output.replace_extension(".ctex");
+        if (fs::remove(output, error)) ++removed;
+    }
+
+    int cooked = 0, skipped = 0, failed = 0;
+    size_t sourceBytes = 0, outputBytes = 0;
+    fs::create_directories(outDir, error);
+    std::ofstream manifest(manifestPath);
+    manifest << "# assetCooker: origem, hash da origem, hash das regras, hash da saída (FNV-1a 64)\n";
+    for (const CookJob& job : jobs) {
+        if (job.failed) { ++failed; continue; }
+        job.skipped ? ++skipped : ++cooked;
+        sourceBytes += job.sourceBytes;
+        outputBytes += job.outputBytes;
+        char line[64];
+        snprintf(line, sizeof(line), " %016llx %016llx %016llx\n", (unsigned long long)job.sourceHash,
+                 (unsigned long long)job.settingsHash, (unsigned long long)job.outputHash);
+        manifest << job.relative << line;
+    }
+    if (!manifest) { fprintf(stderr, "Erro ao gravar %s\n", manifestPath.string().c_str()); return 1; }
+
+    printf("cozidas: %d | sem mudança: %d | falhas: %d | removidas: %d | threads: %u\n",
+           cooked, skipped, failed, removed, pool.size());
+    printf("origem: %.1f MB -> cozido: %.1f MB em %.2f s\n", sourceBytes / 1048576.0, outputBytes / 1048576.0, seconds);
+    return failed > 0 ? 1 : 0;
+}
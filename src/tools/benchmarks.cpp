@@ -0,0 +1,376 @@
+// Micro-benchmarks for the engine modules in Common/ that run without a
+// GL context.
+//
+//   benchmarks path [tamanho] [caminhos] [densidade]
+//       A* (4 e 8 vizinhos) e JPS num grid aleatório; padrão 1024 200 0.2
+//   benchmarks flow [tamanho] [agentes] [ticks]
+//       campo de fluxo com vários objetivos, agentes guiados por ele e
+//       atualização incremental ao remover objetivos; padrão 512 10000 1000
+//   benchmarks colors [lado máximo] [consultas]
+//       consultas de cor por raio (jogo das cores) em grids de 64² até o
+//       lado máximo, índice contra varredura completa; padrão 4096 20
+//   benchmarks anim [atores] [ticks]
+//       Animator com clipes de todos os modos de repetição, tempo por
+//       tick; padrão 100000 600
+//   benchmarks pages [páginas visíveis] [páginas no cache] [quadros]
+//       PageTable (VirtualTexture.h, o PageCache sem GL) com uma vista
+//       parada que mostra mais páginas do que o cache comporta; falha se
+//       alguma página for lida mais de uma vez; padrão 32 24 200
+
+// --- INCLUDE DEFINITIONS ---
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Animation.h"
+#include "ColorIndex.h"
+#include "FlowField.h"
+#include "Pathfinding.h"
+#include "SparseSet.h"
+#include "VirtualTexture.h"
+
+// --- TIMING ---
+struct Timer {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    double seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count(); }
+};
+
+// --- PATH MODE ---
+// Random obstacles (tile 1, blocked) on an open grid (tile 0). Every search
+// pair is checked against the 8-neighbour A* cost so JPS regressions show up.
+int benchPath(int argc, char** argv) {
+    int size       = argc > 2 ? atoi(argv[2]) : 1024;
+    int pairs      = argc > 3 ? atoi(argv[3]) : 200;
+    float density  = argc > 4 ? (float)atof(argv[4]) : 0.2f;
+    if (size < 1 || pairs < 1 || !(density >= 0.0f && density < 1.0f)) {
+        fprintf(stderr, "Parametros invalidos: tamanho e caminhos >= 1, 0 <= densidade < 1\n");
+        return 1;
+    }
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::vector<uint8_t> grid(size * size);
+    for (uint8_t& tile : grid) tile = chance(rng) < density ? 1 : 0;
+
+    Pathfinder pathfinder;
+    pathfinder.setGrid(grid.data(), size, size);
+    pathfinder.setCost(1, PATH_BLOCKED);
+    // A dense or tiny grid may have few or no open tiles; give up rather
+    // than draw pairs forever.
+    std::vector<int> starts, goals;
+    long long attempts = 0, maxAttempts = (long long)pairs * 1000;
+    while ((int)starts.size() < pairs && attempts++ < maxAttempts) {
+        int s = rng() % (size * size), g = rng() % (size * size);
+        if (grid[s] || grid[g]) continue;
+        starts.push_back(s);
+        goals.push_back(g);
+    }
+    if ((int)starts.size() < pairs) {
+        fprintf(stderr, "Poucas celulas livres: %zu de %d pares em %lld tentativas\n", starts.size(), pairs, maxAttempts);
+        return 1;
+    }
+
+    printf("grid %dx%d, %.0f%% obstaculos, %d pares\n", size, size, density * 100.0f, pairs);
+    std::vector<float> reference(pairs, -1.0f);
+    std::vector<int> path;
+    const char* names[3] = { "A* 4 vizinhos", "A* 8 vizinhos", "JPS" };
+    for (int mode = 0; mode < 3; ++mode) {
+        pathfinder.setNeighbours(mode == 0 ? NEIGHBOURS_4 : NEIGHBOURS_8);
+        int found = 0, mismatches = 0;
+        double expanded = 0.0;
+        Timer timer;
+        for (int i = 0; i < pairs; ++i) {
+            int sx = starts[i] % size, sy = starts[i] / size, gx = goals[i] % size, gy = goals[i] / size;
+            bool ok = mode == 2 ? pathfinder.findPathJPS(sx, sy, gx, gy, path) : pathfinder.findPath(sx, sy, gx, gy, path);
+            expanded += pathfinder.lastStats().expanded;
+            if (!ok) continue;
+            found++;
+            float cost = pathfinder.lastStats().cost;
+            if (mode == 1) reference[i] = cost;
+            if (mode == 2 && fabsf(cost - reference[i]) > 1e-2f * cost) mismatches++;
+        }
+        double seconds = timer.seconds();
+        printf("%-14s %8.1f caminhos/s | %6.2f ms/caminho | %9.0f nos expandidos | %d encontrados",
+               names[mode], pairs / seconds, seconds * 1000.0 / pairs, expanded / pairs, found);
+        if (mode == 2) printf(" | %d custos divergentes", mismatches);
+        printf("\n");
+    }
+    return 0;
+}
+
+// --- FLOW MODE ---
+// Agents walk down a multi-goal flow field; goals are then removed one by
+// one (coins being picked up) and the incremental repair is compared with
+// a full rebuild.
+int benchFlow(int argc, char** argv) {
+    int size   = argc > 2 ? atoi(argv[2]) : 512;
+    int agents = argc > 3 ? atoi(argv[3]) : 10000;
+    int ticks  = argc > 4 ? atoi(argv[4]) : 1000;
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::vector<uint8_t> grid(size * size);
+    for (uint8_t& tile : grid) {
+        float roll = chance(rng);
+        tile = roll < 0.15f ? 1 : (roll < 0.25f ? 2 : 0);   // walls, mud, floor
+    }
+    std::vector<int> goals;
+    while (goals.size() < 64) {
+        int cell = rng() % (size * size);
+        if (grid[cell] != 1) goals.push_back(cell);
+    }
+
+    FlowField field;
+    field.setGrid(grid.data(), size, size);
+    field.setCost(1, FLOW_BLOCKED);
+    field.setCost(2, 3);
+    Timer buildTimer;
+    field.compute(goals);
+    double buildMs = buildTimer.seconds() * 1000.0;
+    printf("grid %dx%d, %zu objetivos: campo completo em %.2f ms (%u celulas)\n",
+           size, size, goals.size(), buildMs, field.lastSettled());
+
+    // Agents that reach a goal respawn on a cell that still has somewhere
+    // to go, so every lookup is a moving agent. Spawn cells are drawn
+    // before the timer starts.
+    std::vector<int> spawns(4096);
+    for (int& cell : spawns) {
+        do cell = rng() % (size * size); while (grid[cell] == 1 || field.next(cell) < 0);
+    }
+    std::vector<int> positions(agents);
+    for (int i = 0; i < agents; ++i) positions[i] = spawns[i % spawns.size()];
+    Timer steerTimer;
+    long long arrived = 0;
+    size_t spawn = agents;
+    for (int t = 0; t < ticks; ++t) {
+        for (int& cell : positions) {
+            int next = field.next(cell);
+            if (next >= 0) {
+                cell = next;
+            } else {
+                arrived++;
+                cell = spawns[spawn++ % spawns.size()];
+            }
+        }
+    }
+    double steerSeconds = steerTimer.seconds();
+    printf("%d agentes x %d ticks: %.3f ms/tick, %.1f M passos/s (%lld chegadas, reposicionados)\n",
+           agents, ticks, steerSeconds * 1000.0 / ticks, (double)agents * ticks / steerSeconds / 1e6, arrived);
+
+    int removals = (int)goals.size() / 2;
+    Timer incrementalTimer;
+    unsigned settled = 0;
+    for (int i = 0; i < removals; ++i) {
+        field.removeGoal(goals[i]);
+        settled += field.lastSettled();
+    }
+    double incrementalMs = incrementalTimer.seconds() * 1000.0 / removals;
+    std::vector<int> remaining(goals.begin() + removals, goals.end());
+    FlowField reference;
+    reference.setGrid(grid.data(), size, size);
+    reference.setCost(1, FLOW_BLOCKED);
+    reference.setCost(2, 3);
+    Timer fullTimer;
+    reference.compute(remaining);
+    double fullMs = fullTimer.seconds() * 1000.0;
+    int mismatches = 0;
+    for (int cell = 0; cell < size * size; ++cell) mismatches += field.distance(cell) != reference.distance(cell);
+    printf("remocao de objetivo: %.2f ms incremental (%u celulas em media) vs %.2f ms completo | %d divergencias\n",
+           incrementalMs, settled / removals, fullMs, mismatches);
+    return 0;
+}
+
+// --- COLORS MODE ---
+// Radius-0.5 colour queries as in tarefa03's whipeQuads(). For each grid
+// size: the original per-cell sqrt/pow scan, ColorIndex::query() on the
+// same colours (results must match), and a whole game of wipes with
+// extractWithin() until the grid is empty.
+int benchColors(int argc, char** argv) {
+    int maxSide = argc > 2 ? atoi(argv[2]) : 4096;
+    int queries = argc > 3 ? atoi(argv[3]) : 20;
+    const float radius = 0.5f;
+    std::mt19937 rng(777);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    for (int side = 64; side <= maxSide; side *= 4) {
+        uint32_t count = (uint32_t)side * side;
+        std::vector<float> rgb(count * 3);
+        for (float& c : rgb) c = chance(rng);
+        std::vector<uint32_t> probes(queries);
+        for (uint32_t& p : probes) p = rng() % count;
+
+        Timer scanTimer;
+        std::vector<size_t> expected(queries, 0);
+        for (int q = 0; q < queries; ++q) {
+            const float* c = &rgb[probes[q] * 3];
+            for (uint32_t id = 0; id < count; ++id) {
+                const float* o = &rgb[id * 3];
+                double d = sqrt(pow(c[0] - o[0], 2) + pow(c[1] - o[1], 2) + pow(c[2] - o[2], 2));
+                if (d <= radius) expected[q]++;
+            }
+        }
+        double scanSeconds = scanTimer.seconds();
+
+        ColorIndex index;
+        Timer buildTimer;
+        index.build(rgb.data(), count);
+        double buildMs = buildTimer.seconds() * 1000.0;
+        std::vector<uint32_t> found;
+        int mismatches = 0;
+        Timer queryTimer;
+        for (int q = 0; q < queries; ++q) {
+            const float* c = &rgb[probes[q] * 3];
+            found.clear();
+            // float squared distances against the scan's double sqrt: only
+            // colours right on the radius may round to the other side
+            if (index.query(c[0], c[1], c[2], radius, found) != expected[q]) mismatches++;
+        }
+        double querySeconds = queryTimer.seconds();
+
+        // a full game: click a random remaining cell until none are left
+        SparseSet alive;
+        alive.init(count);
+        for (uint32_t id = 0; id < count; ++id) alive.insert(id);
+        int clicks = 0;
+        Timer gameTimer;
+        while (!alive.empty()) {
+            const float* c = &rgb[alive[rng() % alive.size()] * 3];
+            found.clear();
+            index.extractWithin(c[0], c[1], c[2], radius, found);
+            for (uint32_t id : found) alive.erase(id);
+            clicks++;
+        }
+        double gameMs = gameTimer.seconds() * 1000.0;
+
+        printf("%5dx%-5d (%2d^3 baldes, %.0f ms p/ indexar): varredura %9.1f consultas/s | indice %9.1f consultas/s (%.1fx) | %d com arredondamento diferente | jogo completo: %d cliques em %.1f ms\n",
+               side, side, index.resolution(), buildMs, queries / scanSeconds, queries / querySeconds,
+               scanSeconds / querySeconds, mismatches, clicks, gameMs);
+    }
+    return 0;
+}
+
+// --- ANIM MODE ---
+// Actors spread over clips of every loop mode, one with uneven frame
+// durations, at random speeds and phases, advanced at 60 Hz.
+const char* BENCH_CLIPS = R"(
+sheet knight knight.png 8 4
+sheet coin coin.png 10 1
+clip walk loop
+frames knight 0 8 0.1
+clip attack once
+frames knight 8 4 0.15
+clip idle pingpong
+frames knight 16 6 0.15
+clip spin loop
+frames coin 0 5 0.05
+frame coin 5 0.2
+frames coin 6 4 0.0667
+)";
+
+int benchAnim(int argc, char** argv) {
+    int actors = argc > 2 ? atoi(argv[2]) : 100000;
+    int ticks  = argc > 3 ? atoi(argv[3]) : 600;
+    std::istringstream description(BENCH_CLIPS);
+    AnimationLibrary library;
+    if (!library.load(description, "benchmarks")) return 1;
+    int clipCount = (int)library.getClips().size();
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    Animator animator(&library);
+    animator.reserve(actors);
+    for (int i = 0; i < actors; ++i) {
+        int clip = i % clipCount;
+        animator.add(clip, 0.5f + chance(rng), chance(rng) * library.clip(clip).seconds);
+    }
+
+    Timer timer;
+    double worstMs = 0.0;
+    for (int t = 0; t < ticks; ++t) {
+        Timer tickTimer;
+        animator.update(1.0f / 60.0f);
+        worstMs = std::max(worstMs, tickTimer.seconds() * 1000.0);
+    }
+    double tickMs = timer.seconds() * 1000.0 / ticks;
+    double checksum = 0.0;
+    for (int i = 0; i < actors; ++i) checksum += animator.rect(i).u0 + animator.sheet(i);
+    printf("%d atores, %d clipes, %d ticks: %.3f ms/tick (pior %.3f ms), %.1f M atores/s | soma %.1f\n",
+           actors, clipCount, ticks, tickMs, worstMs, actors / tickMs / 1000.0, checksum);
+    return 0;
+}
+
+// --- PAGES MODE ---
+// A one-row image of `visible` blank pages, all of them on screen every
+// frame. Once the cache is full every slot is drawn each frame, so nothing
+// can be evicted and no more pages should be read.
+int benchPages(int argc, char** argv) {
+    int visible  = argc > 2 ? atoi(argv[2]) : 32;
+    int capacity = argc > 3 ? atoi(argv[3]) : 24;
+    int frames   = argc > 4 ? atoi(argv[4]) : 200;
+    if (visible < 1 || capacity < 1 || frames < 1) {
+        fprintf(stderr, "Parametros invalidos: paginas e quadros >= 1\n");
+        return 1;
+    }
+    const uint32_t pageSize = 64;
+    std::string path = (std::filesystem::temp_directory_path() / "benchmarks_pages.vtex").string();
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        fprintf(stderr, "Erro ao criar %s\n", path.c_str());
+        return 1;
+    }
+    VirtualTextureInfo info;
+    info.width = visible * pageSize; info.height = pageSize; info.pageSize = pageSize;
+    info.fallbackWidth = 1; info.fallbackHeight = 1;
+    uint32_t header[6] = { VTEX_VERSION, info.width, info.height, info.pageSize, info.fallbackWidth, info.fallbackHeight };
+    std::vector<unsigned char> pixels(info.pageBytes());
+    fwrite("VTEX", 1, 4, file);
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(pixels.data(), 1, 4, file);
+    for (int i = 0; i < visible; ++i) fwrite(pixels.data(), 1, pixels.size(), file);
+    fclose(file);
+
+    PageTable cache;
+    cache.init(pageSize, capacity);
+    int source = cache.addSource(path);
+    if (source < 0) return 1;
+    Timer timer;
+    for (int f = 0; f < frames; ++f) {
+        cache.beginFrame();
+        for (int col = 0; col < visible; ++col)
+            if (cache.lookup(source, col, 0) < 0) cache.want(source, col, 0, true);
+        cache.endFrame();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));   // time for the worker to read
+    }
+    double seconds = timer.seconds();
+    unsigned reads = cache.readCount();
+    int resident = cache.residentPages(), slots = cache.capacity();
+    cache.destroy();
+    std::filesystem::remove(path);
+    printf("%d paginas visiveis, %d no cache, %d quadros em %.2f s: %u leituras, %u envios, %d residentes\n",
+           visible, slots, frames, seconds, reads, cache.uploadCount(), resident);
+    if ((int)reads > visible) {
+        fprintf(stderr, "Paginas lidas mais de uma vez: %u leituras para %d paginas\n", reads, visible);
+        return 1;
+    }
+    return 0;
+}
+
+// --- MAIN ---
+int main(int argc, char** argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "path") return benchPath(argc, argv);
+    if (mode == "flow") return benchFlow(argc, argv);
+    if (mode == "colors") return benchColors(argc, argv);
+    if (mode == "anim") return benchAnim(argc, argv);
+    if (mode == "pages") return benchPages(argc, argv);
+    fprintf(stderr, "uso: benchmarks <modo> [argumentos]\n");
+    fprintf(stderr, "  path [tamanho] [caminhos] [densidade]\n");
+    fprintf(stderr, "  flow [tamanho] [agentes] [ticks]\n");
+    fprintf(stderr, "  colors [lado maximo] [consultas]\n");
+    fprintf(stderr, "  anim [atores] [ticks]\n");
+    fprintf(stderr, "  pages [paginas visiveis] [paginas no cache] [quadros]\n");
+    return 1;
+}
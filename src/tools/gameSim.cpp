@@ -0,0 +1,211 @@
+// Headless batch simulator for grauB levels. Runs many games in parallel
+// with the rules in IsoGame.h, driven by random or scripted input, and
+// reports simulated ticks per second and how the games ended.
+//
+//   gameSim [opções] [mapa.txt ...]
+//     --generate N      gera N níveis aleatórios (além dos mapas passados)
+//     --size R C        dimensões dos níveis gerados (padrão 15 15)
+//     --games K         partidas por nível (padrão 16)
+//     --ticks T         limite de ticks por partida (padrão 36000 = 10 min)
+//     --threads N       threads de simulação (padrão: todas)
+//     --seed S          semente dos níveis e das entradas (padrão 1)
+//     --cautious        o andarilho aleatório evita lava
+//     --script ARQ      usa a sequência de movimentos do arquivo (U D L R .)
+//                       em vez de entradas aleatórias
+
+// --- INCLUDE DEFINITIONS ---
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "IsoGame.h"
+#include "ThreadPool.h"
+
+// --- INPUT SOURCES ---
+// Random walker: picks a new direction every move slot, never stands still.
+// A cautious walker re-rolls directions that lead into lava.
+struct RandomInput {
+    std::mt19937 rng;
+    bool cautious;
+    GameInput current;
+    RandomInput(uint32_t seed, bool cautious) : rng(seed), cautious(cautious) {}
+    GameInput next(const GameState& state) {
+        if ((state.tick % MOVE_COOLDOWN_TICKS) == 0) {
+            static const int dirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+            for (int attempt = 0; attempt < 8; ++attempt) {
+                int d = rng() % 4;
+                current.dx = dirs[d][0];
+                current.dy = dirs[d][1];
+                int r = state.playerY + current.dy, c = state.playerX + current.dx;
+                if (!cautious || !state.map.inside(r, c) || state.map.at(r, c).tileIndex != TILE_LAVA) break;
+            }
+        }
+        return current;
+    }
+};
+
+// Scripted input: each character is held for one move slot; the script
+// loops when it runs out.
+struct ScriptInput {
+    const std::string* script;
+    GameInput next(const GameState& state) {
+        GameInput input;
+        if (script->empty()) return input;
+        char c = (*script)[(state.tick / MOVE_COOLDOWN_TICKS) % script->size()];
+        if (c == 'U') input.dy = -1;
+        if (c == 'D') input.dy = 1;
+        if (c == 'L') input.dx = -1;
+        if (c == 'R') input.dx = 1;
+        return input;
+    }
+};
+
+// --- LEVEL ANALYSIS ---
+// True when every coin can be reached from the start without stepping on
+// lava or walls, i.e. the level can be won at all. An empty map can't.
+bool isSolvable(const GameState& state) {
+    const IsoMap& map = state.map;
+    if (map.tiles.empty() || !map.inside(state.playerY, state.playerX)) return false;
+    std::vector<char> seen(map.tiles.size(), 0);
+    std::vector<int> frontier;
+    int start = state.playerY * map.cols + state.playerX;
+    frontier.push_back(start);
+    seen[start] = 1;
+    int coins = 0;
+    while (!frontier.empty()) {
+        int cell = frontier.back();
+        frontier.pop_back();
+        if (map.coins.contains(cell)) coins++;
+        int row = cell / map.cols, col = cell % map.cols;
+        static const int dirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        for (const auto& d : dirs) {
+            int r = row + d[1], c = col + d[0];
+            if (!map.inside(r, c)) continue;
+            int next = r * map.cols + c;
+            int tile = map.tiles[next].tileIndex;
+            if (seen[next] || tile == TILE_WALL || tile == TILE_LAVA) continue;
+            seen[next] = 1;
+            frontier.push_back(next);
+        }
+    }
+    return coins == state.totalCoins;
+}
+
+// --- RESULTS ---
+struct LevelResult {
+    bool solvable = false;
+    int won = 0, lava = 0, timeout = 0;
+    uint64_t ticks = 0;
+    uint64_t ticksToWin = 0;
+    int coinsCollected = 0;
+};
+
+LevelResult simulateLevel(const IsoMap& level, int games, uint64_t tickLimit, uint32_t seed, bool cautious, const std::string* script) {
+    LevelResult result;
+    for (int g = 0; g < games; ++g) {
+        GameState state;
+        state.level = level;
+        resetGame(state);
+        if (g == 0) result.solvable = isSolvable(state);
+        RandomInput random(seed * 7919u + g, cautious);
+        ScriptInput scripted = { script };
+        while (state.status == RUNNING && state.tick < tickLimit) {
+            GameInput input = script ? scripted.next(state) : random.next(state);
+            step(state, input);
+        }
+        result.ticks += state.tick;
+        result.coinsCollected += state.coinCount;
+        if (state.status == WON) {
+            result.won++;
+            result.ticksToWin += state.endTick - state.startTick;
+        } else if (state.status == GAMEOVER) result.lava++;
+        else result.timeout++;
+    }
+    return result;
+}
+
+// --- MAIN ---
+int main(int argc, char** argv) {
+    std::vector<std::string> mapPaths;
+    int generate = 0, rows = 15, cols = 15, games = 16;
+    uint64_t tickLimit = 36000;
+    unsigned threads = 0;
+    uint32_t seed = 1;
+    std::string script;
+    bool useScript = false, cautious = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--generate" && i + 1 < argc)    generate = atoi(argv[++i]);
+        else if (arg == "--size" && i + 2 < argc) { rows = atoi(argv[++i]); cols = atoi(argv[++i]); }
+        else if (arg == "--games" && i + 1 < argc)  games = atoi(argv[++i]);
+        else if (arg == "--ticks" && i + 1 < argc)  tickLimit = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--threads" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc)   seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--cautious")               cautious = true;
+        else if (arg == "--script" && i + 1 < argc) {
+            std::ifstream file(argv[++i]);
+            if (!file) { fprintf(stderr, "Erro ao abrir %s\n", argv[i]); return 1; }
+            char c;
+            while (file.get(c)) if (strchr("UDLR.", c)) script += c;
+            useScript = true;
+        }
+        else if (arg[0] != '-') mapPaths.push_back(arg);
+        else { fprintf(stderr, "Opção desconhecida: %s\n", argv[i]); return 1; }
+    }
+    if (generate > 0 && (rows < 1 || cols < 1)) {
+        fprintf(stderr, "Tamanho invalido: %d x %d (--size R C, com R e C >= 1)\n", rows, cols);
+        return 1;
+    }
+    if (mapPaths.empty() && generate == 0) mapPaths.push_back("../assets/map.txt");
+
+    std::vector<IsoMap> levels;
+    for (const std::string& path : mapPaths) {
+        IsoMap map;
+        if (loadIsoMap(path, map)) levels.push_back(map);
+    }
+    for (int i = 0; i < generate; ++i) levels.push_back(generateIsoMap(rows, cols, seed + i));
+    if (levels.empty()) { fprintf(stderr, "Nenhum nível para simular\n"); return 1; }
+
+    std::vector<LevelResult> results(levels.size());
+    ThreadPool pool(threads);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < levels.size(); ++i) {
+        pool.submit([&, i] {
+            results[i] = simulateLevel(levels[i], games, tickLimit, seed + (uint32_t)i, cautious,
+                                       useScript ? &script : nullptr);
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    LevelResult total;
+    int solvable = 0;
+    for (const LevelResult& r : results) {
+        solvable         += r.solvable;
+        total.won        += r.won;
+        total.lava       += r.lava;
+        total.timeout    += r.timeout;
+        total.ticks      += r.ticks;
+        total.ticksToWin += r.ticksToWin;
+        total.coinsCollected += r.coinsCollected;
+    }
+    int totalGames = (int)levels.size() * games;
+    printf("niveis: %zu (%d resolviveis) | partidas: %d | threads: %u\n", levels.size(), solvable, totalGames, pool.size());
+    printf("ticks simulados: %llu em %.3f s -> %.0f ticks/s, %.0f niveis/min\n",
+           (unsigned long long)total.ticks, seconds, total.ticks / seconds, levels.size() / seconds * 60.0);
+    printf("vitorias: %d | lava: %d | tempo esgotado: %d | moedas por partida: %.1f\n",
+           total.won, total.lava, total.timeout, (double)total.coinsCollected / totalGames);
+    if (total.won > 0) printf("tempo medio ate a vitoria: %.1f s\n", (double)total.ticksToWin / total.won / ISO_TICK_RATE);
+    if (levels.size() <= 16) {
+        for (size_t i = 0; i < levels.size(); ++i) {
+            const LevelResult& r = results[i];
+            printf("  nivel %zu: %s, %d vitorias, %d lava, %d tempo esgotado\n", i,
+                   r.solvable ? "resolvivel" : "impossivel", r.won, r.lava, r.timeout);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// Startup benchmark. Launches each exercise N times with
+// --startup-trace (StartupTrace.h: hidden window, one frame, then exit)
+// and reports how long each init phase took, with percentiles, plus the
+// wall time of the whole process as seen from outside. Run it from the
+// build directory, where the exercises find ../assets.
+//
+//   startupBench [opções] [programa ...]   (padrão: todos os EXERCISES)
+//     --runs N          execuções medidas por programa (padrão 10)
+//     --warmup N        execuções descartadas antes das medidas (padrão 0,
+//                       para medir a partida a frio)
+//     --dir DIR         pasta dos executáveis (padrão .)
+//     --csv ARQ         grava todas as amostras (programa, execução, fase, ms)
+//                       para comparar entre commits
+
+// --- INCLUDE DEFINITIONS ---
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef EXERCISE_NAMES
+#define EXERCISE_NAMES "tarefa02 tarefa03 tarefa04 tarefa05 vivencial01 vivencial02 vivencial03 grauB"
+#endif
+
+#ifdef _WIN32
+const char* EXE_SUFFIX = ".exe";
+const char* DISCARD_OUTPUT = " > NUL 2>&1";
+#else
+const char* EXE_SUFFIX = "";
+const char* DISCARD_OUTPUT = " > /dev/null 2>&1";
+#endif
+
+// --- SAMPLES ---
+// Phases in the order the program first reported them; "process" is the
+// wall time of the launch, measured here.
+struct PhaseSamples {
+    std::string name;
+    std::vector<double> ms;
+};
+
+struct ProgramSamples {
+    std::string name;
+    std::vector<PhaseSamples> phases;
+    int failures = 0;
+
+    std::vector<double>& phase(const std::string& phaseName) {
+        for (PhaseSamples& p : phases)
+            if (p.name == phaseName) return p.ms;
+        phases.push_back(PhaseSamples{ phaseName, {} });
+        return phases.back().ms;
+    }
+};
+
+// Parses "prog fase=ms ... total=ms".
+static bool parseTrace(const std::string& line, std::vector<std::pair<std::string, double>>& phases) {
+    std::istringstream in(line);
+    std::string program, field;
+    if (!(in >> program)) return false;
+    while (in >> field) {
+        size_t eq = field.find('=');
+        if (eq == std::string::npos) return false;
+        phases.emplace_back(field.substr(0, eq), atof(field.c_str() + eq + 1));
+    }
+    return !phases.empty();
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+static void report(const ProgramSamples& samples, int runs) {
+    printf("%s: %d execuções, %d falhas\n", samples.name.c_str(), runs, samples.failures);
+    if (samples.phases.empty()) return;
+    double totalMean = 0.0;
+    for (const PhaseSamples& p : samples.phases) {
+        if (p.name != "total") continue;
+        for (double v : p.ms) totalMean += v / p.ms.size();
+    }
+    printf("  %-12s %9s %9s %9s %9s %9s %6s\n", "fase", "media", "p50", "p90", "p99", "max", "%");
+    for (const PhaseSamples& p : samples.phases) {
+        std::vector<double> sorted(p.ms);
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0.0;
+        for (double v : sorted) mean += v / sorted.size();
+        bool summary = p.name == "total" || p.name == "process";
+        if (summary) printf("  %-12s", p.name == "total" ? "total" : "processo");
+        else printf("  %-12s", p.name.c_str());
+        printf(" %9.2f %9.2f %9.2f %9.2f %9.2f", mean, percentile(sorted, 0.50), percentile(sorted, 0.90),
+               percentile(sorted, 0.99), sorted.back());
+        if (!summary && totalMean > 0.0) printf(" %5.1f%%", 100.0 * mean / totalMean);
+        printf("\n");
+    }
+}
+
+// --- MAIN ---
+int main(int argc, char** argv) {
+    int runs = 10, warmup = 0;
+    std::string dir = ".", csvPath;
+    std::vector<std::string> programs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)           runs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--warmup" && i + 1 < argc)    warmup = std::max(0, atoi(argv[++i]));
+        else if (arg == "--dir" && i + 1 < argc)       dir = argv[++i];
+        else if (arg == "--csv" && i + 1 < argc)       csvPath = argv[++i];
+        else if (arg.rfind("--", 0) != 0)              programs.push_back(arg);
+        else { fprintf(stderr, "Opção desconhecida: %s\n", argv[i]); return 1; }
+    }
+    if (programs.empty()) {
+        std::istringstream names(EXERCISE_NAMES);
+        std::string name;
+        while (names >> name) programs.push_back(name);
+    }
+    std::ofstream csv;
+    if (!csvPath.empty()) {
+        csv.open(csvPath);
+        if (!csv) { fprintf(stderr, "Erro ao criar %s\n", csvPath.c_str()); return 1; }
+        csv << "programa,execucao,fase,ms\n";
+    }
+
+    // removed before every launch, so a run that dies early can't be
+    // credited with the previous run's line
+    std::string tracePath = "startupBench.trace";
+    int failed = 0;
+    for (const std::string& program : programs) {
+        ProgramSamples samples;
+        samples.name = program;
+        std::string command = "\"" + dir + "/" + program + EXE_SUFFIX + "\" --startup-trace " + tracePath + DISCARD_OUTPUT;
+        for (int run = -warmup; run < runs; ++run) {
+            std::remove(tracePath.c_str());
+            auto begin = std::chrono::steady_clock::now();
+            int status = std::system(command.c_str());
+            double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            std::ifstream trace(tracePath);
+            std::string line;
+            if (status != 0 || !std::getline(trace, line)) {
+                if (run >= 0) ++samples.failures;
+                continue;
+            }
+            if (run < 0) continue;
+            std::vector<std::pair<std::string, double>> phases;
+            if (!parseTrace(line, phases)) {
+                ++samples.failures;
+                continue;
+            }
+            phases.emplace_back("process", wallMs);
+            for (const auto& p : phases) {
+                samples.phase(p.first).push_back(p.second);
+                if (csv.is_open()) csv << program << "," << run << "," << p.first << "," << p.second << "\n";
+            }
+        }
+        std::remove(tracePath.c_str());
+        if (samples.failures > 0) ++failed;
+        report(samples, runs);
+    }
+    return failed > 0 ? 1 : 0;
+}
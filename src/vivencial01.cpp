@@ -1,3 +1,7 @@
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <glad/glad.h>
@@ -5,12 +9,19 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "GpuArena.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
 
 const GLint WIDTH = 800, HEIGHT = 600;
-GLuint VAO, VBO;
+GLuint VAO;
 GLuint shader_programme;
-std::vector<GLfloat> vertices;
-std::vector<glm::vec2> points;
+// Triangles live only on the GPU: each one is appended to the arena and
+// all of them are drawn with a single glDrawArrays.
+struct Vertex { GLfloat x, y, z, r, g, b; };
+GpuArena triangleArena;
+unsigned arenaGeneration = 0;   // arena generation the VAO points at
+GLsizei vertexCount = 0;
 std::vector<glm::vec2> temp_points;
 glm::mat4 proj;
 
@@ -33,6 +44,45 @@ const char* fragment_shader = R"(
     void main() { color = vec4(fragColor, 1.0); };
 )";
 
+void appendTriangle(const glm::vec2* corners, glm::vec3 color) {
+    Vertex triangle[3];
+    for (int k = 0; k < 3; ++k) triangle[k] = { corners[k].x, corners[k].y, 0.0f, color.r, color.g, color.b };
+    triangleArena.append(triangle, sizeof(triangle));
+    vertexCount += 3;
+}
+
+// Re-points the VAO at the arena; needed again whenever the arena grew.
+void pointVertexArray() {
+    glState.bindVertexArray(VAO);
+    glState.bindBuffer(GL_ARRAY_BUFFER, triangleArena.id());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    arenaGeneration = triangleArena.getGeneration();
+}
+
+// Stress test (`vivencial01 <n>`): adds n random triangles one at a time,
+// the same path a click takes, and reports how long it took.
+void addRandomTriangles(int count) {
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        glm::vec2 center(rand() % WIDTH, rand() % HEIGHT);
+        glm::vec2 corners[3];
+        for (glm::vec2& corner : corners) corner = center + glm::vec2(rand() % 41 - 20, rand() % 41 - 20);
+        glm::vec3 color(
+            static_cast<float>(rand()) / RAND_MAX,
+            static_cast<float>(rand()) / RAND_MAX,
+            static_cast<float>(rand()) / RAND_MAX
+        );
+        appendTriangle(corners, color);
+    }
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    printf("%d triângulos adicionados em %.1f ms (%.3f us cada) | %u crescimentos, capacidade %.1f MB\n",
+           count, ms, ms * 1000.0 / count, triangleArena.growCount(), triangleArena.getCapacity() / (1024.0 * 1024.0));
+}
+
 void mouse_callback(GLFWwindow* window, int button, int action, int mods) {
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
         double mx, my;
@@ -44,53 +94,61 @@ void mouse_callback(GLFWwindow* window, int button, int action, int mods) {
                 static_cast<float>(rand()) / RAND_MAX,
                 static_cast<float>(rand()) / RAND_MAX
             );
-            for(const auto& p : temp_points) {
-                vertices.insert(vertices.end(), { p.x, p.y, 0.0f, color.r, color.g, color.b });
-            }
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_DYNAMIC_DRAW);
+            appendTriangle(temp_points.data(), color);
             temp_points.clear();
         }
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    StartupTrace startup;
+    startup.parseArgs(argc, argv);
     glfwInit();
+    startup.phase("glfwInit");
+    if (startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Triângulos coloridos", nullptr, nullptr);
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    startup.phase("glad");
+    if (startup.headless()) glfwSwapInterval(0);
     glfwSetMouseButtonCallback(window, mouse_callback);
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vs, 1, &vertex_shader, NULL);
-    glCompileShader(vs);
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fs, 1, &fragment_shader, NULL);
-    glCompileShader(fs);
-    shader_programme = glCreateProgram();
-    glAttachShader(shader_programme, vs);
-    glAttachShader(shader_programme, fs);
-    glLinkProgram(shader_programme);
+    shader_programme = shaderCache.build("vivencial01", vertex_shader, fragment_shader);
+    startup.phase("shaders");
     glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    triangleArena.init(1024 * sizeof(Vertex));
+    pointVertexArray();
+    // vivencial01 <n>: n random triangles; options like --startup-trace aren't counts
+    if (argc > 1 && isdigit((unsigned char)argv[1][0])) addRandomTriangles(atoi(argv[1]));
     proj = glm::ortho(0.0f, (float)WIDTH, (float)HEIGHT, 0.0f, -1.0f, 1.0f);
+    glUseProgram(shader_programme);
+    glUniformMatrix4fv(glGetUniformLocation(shader_programme, "proj"), 1, GL_FALSE, glm::value_ptr(proj));
+    startup.phase("scene");
+    double lastTitle = glfwGetTime();
+    int frames = 0;
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
-        glUseProgram(shader_programme);
-        glUniformMatrix4fv(glGetUniformLocation(shader_programme, "proj"), 1, GL_FALSE, glm::value_ptr(proj));
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-        glEnableVertexAttribArray(1);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(vertices.size() / 6));
+        if (triangleArena.getGeneration() != arenaGeneration) pointVertexArray();
+        glState.bindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
         glfwSwapBuffers(window);
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
+        frames++;
+        double now = glfwGetTime();
+        if (now - lastTitle > 0.5) {
+            char title[128];
+            snprintf(title, sizeof(title), "Triângulos coloridos | %d triângulos | FPS %.1f", vertexCount / 3, frames / (now - lastTitle));
+            glfwSetWindowTitle(window, title);
+            lastTitle = now;
+            frames = 0;
+        }
     }
+    triangleArena.release();
     glfwTerminate();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -10,6 +10,14 @@ using namespace std;
 #include <GLFW/glfw3.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include "FixedTimestep.h"
+#include "InputQueue.h"
+#include "LayerStack.h"
+#include "ParallaxCompositor.h"
+#include "Replay.h"
+#include "StartupTrace.h"
+#include "ShaderCache.h"
+#include "TextureLoader.h"
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 int setupShader();
@@ -38,14 +46,52 @@ const GLchar *fragmentShaderSource = R"(
     void main() { color = texture(tex_buff,tex_coord); }
 )";
 
-GLuint bgTex[6];
-float parallax[6] = {1.0f, 0.8f, 0.6f, 0.4f, 0.2f, 0.1f};
+// Background layers and their scroll rates come from vivencial02.layers and
+// are composited in one pass, or paged in by a LayerStack if they are too
+// large for one texture array.
+ParallaxCompositor background;
+LayerStack backgroundStack;
+bool composited = false;
 float playerX = 400.0f, playerY = 470.0f;
 float speed = 8.0f;
+
+// Key callbacks only queue events; the player moves in 60 Hz ticks by
+// `speed` per key press or key repeat consumed in that tick.
+// --record ARQ / --replay ARQ [--headless] as described in Replay.h.
+enum Action { ACTION_LEFT, ACTION_RIGHT };
+FixedTimestep timestep(60.0);
+uint64_t tickCount = 0;
+ReplaySession session;
+StartupTrace startup;
+InputActions actions;
+
+void stepPlayer(double tickTime) {
+	session.consume(tickCount, tickTime, [](const InputEvent &e) { actions.apply(e); });
+	for (int k = 0; k < actions.presses(ACTION_LEFT); k++) {
+		if (playerX < 0) { playerX = 800; }
+		else { playerX -= speed; }
+	}
+	for (int k = 0; k < actions.presses(ACTION_RIGHT); k++) {
+		if (playerX > 800) { playerX = 0; }
+		else { playerX += speed; }
+	}
+	actions.endTick();
+	tickCount++;
+}
 glm::mat4 projection = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
 
-int main() {
+int main(int argc, char **argv) {
+	if (!session.parseArgs(argc, argv)) { return 1; }
+	startup.parseArgs(argc, argv);
+	uint32_t seed = 0;
+	string payload;
+	session.start(seed, payload);
+	actions.bind(GLFW_KEY_LEFT, ACTION_LEFT);
+	actions.bind(GLFW_KEY_RIGHT, ACTION_RIGHT);
+	startup.phase("scene");
 	glfwInit();
+	startup.phase("glfwInit");
+	if (session.headless() || startup.headless()) { glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); }
 	GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "Vivencial 2", nullptr, nullptr);
 	if (!window) {
 		std::cerr << "Falha ao criar a janela GLFW" << std::endl;
@@ -53,11 +99,14 @@ int main() {
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
+	if (session.replaying() || startup.headless()) { glfwSwapInterval(0); }
 	glfwSetKeyCallback(window, key_callback);
+	startup.phase("window");
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		std::cerr << "Falha ao inicializar GLAD" << std::endl;
 		return -1;
 	}
+	startup.phase("glad");
 	const GLubyte *renderer = glGetString(GL_RENDERER);
 	const GLubyte *version = glGetString(GL_VERSION);
 	cout << "Renderer: " << renderer << endl;
@@ -65,15 +114,25 @@ int main() {
 	int width, height;
 	glfwGetFramebufferSize(window, &width, &height);
 	glViewport(0, 0, width, height);
+	startup.phase("scene");
 	GLuint shaderID = setupShader();
+	startup.phase("shaders");
 	GLuint VAO = setupSprite();
-	bgTex[0] = loadTexture("../assets/layers/layer06_sky.png");
-	bgTex[1] = loadTexture("../assets/layers/layer05_rocks.png");
-	bgTex[2] = loadTexture("../assets/layers/layer04_clouds.png");
-	bgTex[3] = loadTexture("../assets/layers/layer03_trees.png");
-	bgTex[4] = loadTexture("../assets/layers/layer02_cake.png");
-	bgTex[5] = loadTexture("../assets/layers/layer01_ground.png");
+	LayerConfig layers;
+	if (!layers.load(string("../assets/layers/vivencial02.layers"))) {
+		glfwTerminate();
+		return -1;
+	}
+	composited = background.init(layers, GL_NEAREST);
+	if (composited) { background.setBackground(0.5f, 0.7f, 1.0f); }
+	else if (backgroundStack.load(layers)) { backgroundStack.init(GL_NEAREST); }
+	else {
+		glfwTerminate();
+		return -1;
+	}
+	startup.phase("layers");
 	GLuint playerTex = loadTexture("../assets/sprites/Vampirinho.png");
+	startup.phase("textures");
 	glUseProgram(shaderID);
 	GLint modelLoc = glGetUniformLocation(shaderID, "model");
 	GLint projLoc = glGetUniformLocation(shaderID, "projection");
@@ -87,7 +146,9 @@ int main() {
 	glDepthFunc(GL_ALWAYS);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	while (!glfwWindowShouldClose(window)) {
+	startup.phase("scene");
+	while (!glfwWindowShouldClose(window) && !session.done()) {
+		glfwPollEvents();
         double curr_s = glfwGetTime();
         double elapsed_s = curr_s - prev_s;
         prev_s = curr_s;
@@ -99,81 +160,46 @@ int main() {
             glfwSetWindowTitle(window, tmp);
             title_countdown_s = 0.1;
         }
-		glfwPollEvents();
-		glClearColor(0.5f, 0.7f, 1.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glBindVertexArray(VAO);
-		for (int i = 0; i < 6; i++) {
-			glBindTexture(GL_TEXTURE_2D, bgTex[i]);
-			float offset = -fmod(playerX * parallax[5-i], 800.0f);
-			for (int j = -1; j <= 1; j++) {
-				glm::mat4 model = glm::mat4(1.0f);
-				model = glm::translate(model, glm::vec3(offset + j * 800.0f, 0.0f, 0.0f));
-				model = glm::scale(model, glm::vec3(800.0f, 600.0f, 1.0f));
-				glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			}
+		timestep.accumulate(session.frameDelta(elapsed_s, timestep.step()));
+		while (timestep.tick()) { stepPlayer(curr_s - timestep.lag()); }
+		// one screen width of player movement scrolls a rate-1 layer by one view width
+		float cameraX = playerX / WIDTH * layers.viewWidth;
+		if (composited) {
+			glClear(GL_DEPTH_BUFFER_BIT);
+			background.draw(cameraX);
+		} else {
+			glClearColor(0.5f, 0.7f, 1.0f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			backgroundStack.update(cameraX, 0.0f);
+			backgroundStack.draw();
 		}
+		glUseProgram(shaderID);
+		glBindVertexArray(VAO);
+		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, playerTex);
 		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(playerX - 64, playerY - 64, 0.0f));
 		model = glm::scale(model, glm::vec3(128.0f, 128.0f, 1.0f));
 		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 		glfwSwapBuffers(window);
+		session.endFrame();
+		if (startup.frameDone()) { glfwSetWindowShouldClose(window, GLFW_TRUE); }
 	}
 	glDeleteVertexArrays(1, &VAO);
+	background.destroy();
+	backgroundStack.destroy();
+	session.finish("vivencial02");
 	glfwTerminate();
 	return 0;
 }
 
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode) {
-    if (action == GLFW_PRESS || action == GLFW_REPEAT) {
-        if (key == GLFW_KEY_LEFT) {
-			if (playerX < 0) { playerX = 800; }
-			else { playerX -= speed; }
-        }
-        if (key == GLFW_KEY_RIGHT) {
-            if (playerX > 800) { playerX = 0; }
-			else { playerX += speed; }
-        }
-    }
+    session.push(InputEvent::key(glfwGetTime(), key, action, mode));
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) { glfwSetWindowShouldClose(window, GL_TRUE); }
 }
 
 int setupShader() {
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-	GLint success;
-	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-	if (!success) {
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	GLuint shaderProgram = glCreateProgram();
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-	if (!success) {
-		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-				  << infoLog << std::endl;
-	}
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-	return shaderProgram;
+	return shaderCache.build("vivencial02", vertexShaderSource, fragmentShaderSource);
 }
 
 int setupSprite() {
@@ -206,15 +232,8 @@ int loadTexture(string filePath) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	int width, height, nrChannels;
-	unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-	if (data) {
-		if (nrChannels == 3) { glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data); }
-		else { glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data); }
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else { std::cout << "Failed to load texture" << std::endl; }
-	stbi_image_free(data);
+	// straight alpha: grauB's premultiplied cooked copy is skipped and the PNG decoded
+	uploadTexture(filePath);
 	glBindTexture(GL_TEXTURE_2D, 0);
 	return texID;
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "StartupTrace.h"
+#include "ShaderCache.h"
 
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
@@ -48,17 +50,7 @@ GLuint createShaderProgram() {
         uniform sampler2D tileset;
         void main() { FragColor = texture(tileset, TexCoord); }
     )";
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    GLuint program = glCreateProgram();
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(vertexShader);
-    glCompileShader(fragmentShader);
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-    return program;
+    return shaderCache.build("vivencial03", vertexShaderSource, fragmentShaderSource);
 }
 
 void loadTileset(const std::string& path) {
@@ -202,19 +194,29 @@ void drawPlayer(int i, int j, glm::mat4 projection) {
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 }
 
-int main() {
+int main(int argc, char** argv) {
+    StartupTrace startup;
+    startup.parseArgs(argc, argv);
     glfwInit();
+    startup.phase("glfwInit");
+    if (startup.headless()) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
     GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Tilemap Isometrico", NULL, NULL);
     glfwMakeContextCurrent(window);
+    startup.phase("window");
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+    startup.phase("glad");
+    if (startup.headless()) glfwSwapInterval(0);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     shaderProgram = createShaderProgram();
     glUseProgram(shaderProgram);
+    startup.phase("shaders");
     loadTileset("../assets/tilesets/tilesetIso.png");
     loadPlayerTexture("../assets/sprites/Vampirinho.png");
+    startup.phase("textures");
     initBuffers();
     glm::mat4 projection = glm::ortho(0.0f, (float)SCREEN_WIDTH, (float)SCREEN_HEIGHT, 0.0f);
+    startup.phase("scene");
     while (!glfwWindowShouldClose(window)) {
         processInput(window);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -223,6 +225,7 @@ int main() {
             drawTile(map[i][j], i, j, projection);
         drawPlayer(playerY, playerX, projection);
         glfwSwapBuffers(window);
+        if (startup.frameDone()) glfwSetWindowShouldClose(window, GLFW_TRUE);
         glfwPollEvents();
     }
     glfwTerminate();